@@ -0,0 +1,3869 @@
+#include "TaskBoard.h"
+#include <sstream>
+#include <fstream>
+#include <ctime>
+#include <charconv>
+#include <filesystem>
+#include <numeric>
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define TASKBOARD_X86 1
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#include <immintrin.h>
+#endif
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+using namespace std;
+
+
+// ---------- Dates ----------
+
+// Reads 1-`maxDigits` digits at s[pos], advancing pos.
+bool readDigits(string_view s, size_t &pos, int maxDigits, int &out) {
+    size_t start = pos;
+    out = 0;
+    while (pos < s.size() && pos - start < (size_t)maxDigits && s[pos] >= '0' && s[pos] <= '9')
+        out = out * 10 + (s[pos++] - '0');
+    return pos > start;
+}
+
+long long daysFromCivil(int y, int m, int d) {
+    y -= m <= 2;
+    long long era = (y >= 0 ? y : y - 399) / 400;
+    long long yoe = y - era * 400;
+    long long doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    long long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+int daysInMonth(int y, int m) {
+    static const int days[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    return (m == 2 && isLeapYear(y)) ? 29 : days[m - 1];
+}
+
+bool parseDateTime(string_view s, long long &minutes) {
+    size_t pos = 0;
+    int day, month, year, hour, minute;
+    if (!readDigits(s, pos, 2, day) || pos >= s.size() || s[pos++] != '/') return false;
+    if (!readDigits(s, pos, 2, month) || pos >= s.size() || s[pos++] != '/') return false;
+    size_t yearStart = pos;
+    if (!readDigits(s, pos, 4, year) || pos - yearStart != 4) return false;
+    if (pos >= s.size() || s[pos++] != ' ') return false;
+    if (!readDigits(s, pos, 2, hour) || pos >= s.size() || s[pos++] != ':') return false;
+    size_t minuteStart = pos;
+    if (!readDigits(s, pos, 2, minute) || pos - minuteStart != 2 || pos != s.size()) return false;
+
+    if (month < 1 || month > 12 || day < 1 || day > daysInMonth(year, month)) return false;
+    if (hour > 23 || minute > 59) return false;
+    minutes = daysFromCivil(year, month, day) * 1440 + hour * 60 + minute;
+    return true;
+}
+
+void civilFromDays(long long z, int &y, int &m, int &d) {
+    z += 719468;
+    long long era = (z >= 0 ? z : z - 146096) / 146097;
+    long long doe = z - era * 146097;
+    long long yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    long long doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    long long mp = (5 * doy + 2) / 153;
+    d = (int)(doy - (153 * mp + 2) / 5 + 1);
+    m = (int)(mp < 10 ? mp + 3 : mp - 9);
+    y = (int)(yoe + era * 400 + (m <= 2));
+}
+
+size_t formatDateTimeTo(char *buf, size_t size, long long minutes) {
+    long long days = minutes >= 0 ? minutes / 1440 : -((-minutes + 1439) / 1440);
+    int minuteOfDay = (int)(minutes - days * 1440);
+    int y, m, d;
+    civilFromDays(days, y, m, d);
+    int n = snprintf(buf, size, "%d/%d/%04d %d:%02d", d, m, y, minuteOfDay / 60, minuteOfDay % 60);
+    return n < 0 ? 0 : min((size_t)n, size - 1);
+}
+
+string formatDateTime(long long minutes) {
+    char buf[32];
+    return string(buf, formatDateTimeTo(buf, sizeof(buf), minutes));
+}
+
+long long nowWallMinutes() {
+    time_t now = time(0);
+    tm local;
+#ifdef _WIN32
+    localtime_s(&local, &now);
+#else
+    localtime_r(&now, &local);
+#endif
+    return daysFromCivil(local.tm_year + 1900, local.tm_mon + 1, local.tm_mday) * 1440
+         + local.tm_hour * 60 + local.tm_min;
+}
+
+
+// ---------- Instrumentation ----------
+
+MetricStats metrics[METRIC_COUNT];
+const chrono::steady_clock::time_point PROGRAM_START = chrono::steady_clock::now();
+
+thread_local uint64_t threadAllocs = 0, threadAllocBytes = 0;
+atomic<uint64_t> totalAllocs{0}, totalAllocBytes{0};
+
+string metricsJSON() {
+    char buf[512];
+    double uptime = chrono::duration<double, milli>(chrono::steady_clock::now() - PROGRAM_START).count();
+    snprintf(buf, sizeof(buf), "{\"uptime_ms\":%.1f,\"allocations\":%llu,\"allocated_bytes\":%llu,\"operations\":[",
+             uptime, (unsigned long long)totalAllocs.load(memory_order_relaxed),
+             (unsigned long long)totalAllocBytes.load(memory_order_relaxed));
+    string out = buf;
+    bool first = true;
+    for (int m = 0; m < METRIC_COUNT; ++m) {
+        const MetricStats &s = metrics[m];
+        uint64_t runs = s.count.load(memory_order_relaxed);
+        if (runs == 0) continue;
+        auto us = [](uint64_t ns) { return ns / 1e3; };
+        snprintf(buf, sizeof(buf),
+                 "%s{\"name\":\"%s\",\"count\":%llu,\"total_us\":%.3f,\"mean_us\":%.3f,\"p50_us\":%.3f,"
+                 "\"p90_us\":%.3f,\"p99_us\":%.3f,\"p999_us\":%.3f,\"max_us\":%.3f,\"rows\":%llu,"
+                 "\"bytes_in\":%llu,\"bytes_out\":%llu,\"allocs\":%llu,\"alloc_bytes\":%llu}",
+                 first ? "" : ",", METRIC_NAMES[m], (unsigned long long)runs,
+                 us(s.totalNs.load(memory_order_relaxed)), us(s.totalNs.load(memory_order_relaxed)) / runs,
+                 us(s.percentileNs(0.5)), us(s.percentileNs(0.9)), us(s.percentileNs(0.99)),
+                 us(s.percentileNs(0.999)), us(s.maxNs.load(memory_order_relaxed)),
+                 (unsigned long long)s.rows.load(memory_order_relaxed),
+                 (unsigned long long)s.bytesIn.load(memory_order_relaxed),
+                 (unsigned long long)s.bytesOut.load(memory_order_relaxed),
+                 (unsigned long long)s.allocs.load(memory_order_relaxed),
+                 (unsigned long long)s.allocBytes.load(memory_order_relaxed));
+        out += buf;
+        first = false;
+    }
+    out += "]}";
+    return out;
+}
+
+bool writeMetrics(const string &path) {
+    ofstream out(path);
+    out << metricsJSON() << "\n";
+    return (bool)out;
+}
+
+
+// ---------- Cells ----------
+
+// Intern table for links, keyed by views into the SharedText buffers.
+mutex internMutex;
+unordered_map<string_view, SharedText *> internTable;
+
+SharedText *internText(string_view s) {
+    lock_guard<mutex> lock(internMutex);
+    auto it = internTable.find(s);
+    if (it != internTable.end()) {
+        it->second->refs.fetch_add(1, memory_order_relaxed);
+        return it->second;
+    }
+    SharedText *t = SharedText::create(s, true);
+    internTable.emplace(t->view(), t);
+    return t;
+}
+
+void releaseText(SharedText *t) {
+    if (!t->interned) {
+        if (t->refs.fetch_sub(1, memory_order_acq_rel) == 1) SharedText::destroy(t);
+        return;
+    }
+    // Interned text may be looked up again concurrently, so dropping the
+    // last reference and leaving the table happen under the same lock.
+    lock_guard<mutex> lock(internMutex);
+    if (t->refs.fetch_sub(1, memory_order_acq_rel) == 1) {
+        internTable.erase(t->view());
+        SharedText::destroy(t);
+    }
+}
+
+bool setDeadline(Task &t, string_view text) {
+    t.deadline.assign(text.data(), text.size());
+    if (parseDateTime(text, t.deadlineMinutes)) return true;
+    t.deadlineMinutes = NO_DEADLINE;
+    return false;
+}
+
+
+// ---------- Typed values from text ----------
+
+string dataTypeName(DataType t) {
+    switch (t) {
+        case DT_INT: return "INT";
+        case DT_STRING: return "STRING";
+        case DT_BOOL: return "BOOL";
+        case DT_FLOAT: return "FLOAT";
+        case DT_DATE: return "DATE";
+        case DT_LINK: return "LINK";
+    }
+    return "STRING";
+}
+
+bool parseDataTypeName(string_view s, DataType &t) {
+    const DataType all[] = {DT_INT, DT_STRING, DT_BOOL, DT_FLOAT, DT_DATE, DT_LINK};
+    for (DataType d : all) {
+        if (s == dataTypeName(d)) { t = d; return true; }
+    }
+    return false;
+}
+
+bool parseIntText(string_view s, int &out) {
+    if (!s.empty() && s[0] == '+') s.remove_prefix(1);
+    if (s.empty()) return false;
+    auto res = from_chars(s.data(), s.data() + s.size(), out);
+    return res.ec == errc() && res.ptr == s.data() + s.size();
+}
+
+bool parseFloatText(string_view s, float &out) {
+    if (!s.empty() && s[0] == '+') s.remove_prefix(1);
+    if (s.empty()) return false;
+    auto res = from_chars(s.data(), s.data() + s.size(), out);
+    return res.ec == errc() && res.ptr == s.data() + s.size();
+}
+
+bool parseBoolText(string_view s, bool &out) {
+    string lower(s);
+    transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    if (lower == "yes" || lower == "true") { out = true; return true; }
+    if (lower == "no" || lower == "false") { out = false; return true; }
+    return false;
+}
+
+void setCellFromText(Cell &c, DataType type, string_view text) {
+    switch (type) {
+        case DT_INT: {
+            int v;
+            if (parseIntText(text, v)) { c.setValue(v); return; }
+            break;
+        }
+        case DT_FLOAT: {
+            float v;
+            if (parseFloatText(text, v)) { c.setValue(v); return; }
+            break;
+        }
+        case DT_BOOL: {
+            bool v;
+            if (parseBoolText(text, v)) { c.setValue(v); return; }
+            break;
+        }
+        case DT_DATE: {
+            long long minutes;
+            if (parseDateTime(text, minutes)) { c.setDate(text); return; }
+            break;
+        }
+        case DT_LINK:
+            c.setLink(text);
+            return;
+        default:
+            break;
+    }
+    c.setValue(text);
+}
+
+// Narrows a column's type as sample values are seen. A column is only
+// INT/FLOAT/BOOL/DATE if every non-empty sample parses as one.
+struct ColumnTypeGuess {
+    bool isInt = true, isFloat = true, isBool = true, isDate = true;
+    size_t samples = 0;
+
+    void add(string_view v) {
+        if (v.empty()) return;
+        ++samples;
+        int i; float f; bool b; long long m;
+        if (isInt && !parseIntText(v, i)) isInt = false;
+        if (isFloat && !parseFloatText(v, f)) isFloat = false;
+        if (isBool && !parseBoolText(v, b)) isBool = false;
+        if (isDate && !parseDateTime(v, m)) isDate = false;
+    }
+
+    DataType result() const {
+        if (samples == 0) return DT_STRING;
+        if (isInt) return DT_INT;
+        if (isFloat) return DT_FLOAT;
+        if (isBool) return DT_BOOL;
+        if (isDate) return DT_DATE;
+        return DT_STRING;
+    }
+};
+
+// How many data rows are looked at to guess column types.
+const size_t TYPE_SAMPLE_ROWS = 1000;
+
+// First field of the optional row saveToCSV writes after the header,
+// listing each column's type (e.g. "#types,STRING,STRING,DATE,STRING,INT").
+const char *const CSV_TYPE_ROW_MARKER = "#types";
+
+
+// ---------- Delimiter scanning kernels ----------
+// CSV import and export spend almost all their time looking for the next
+// quote, comma or newline. These kernels compare 16 (SSE2) or 32 (AVX2)
+// bytes at a time; the best one the CPU supports is picked once at
+// startup, with a plain byte loop as the fallback everywhere else.
+
+#if defined(TASKBOARD_X86) && (defined(__GNUC__) || defined(__clang__))
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_SSE2
+#define TARGET_AVX2
+#endif
+
+const char *findAnyScalar(const char *p, const char *end, char a, char b, char c) {
+    for (; p < end; ++p)
+        if (*p == a || *p == b || *p == c) return p;
+    return end;
+}
+
+void countScalar(const char *p, const char *end, size_t &quotes, size_t &newlines) {
+    for (; p < end; ++p) {
+        quotes += (*p == '"');
+        newlines += (*p == '\n');
+    }
+}
+
+#ifdef TASKBOARD_X86
+inline int lowestSetBit(unsigned mask) {
+#ifdef _MSC_VER
+    unsigned long idx;
+    _BitScanForward(&idx, mask);
+    return (int)idx;
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+TARGET_SSE2 const char *findAnySSE2(const char *p, const char *end, char a, char b, char c) {
+    const __m128i va = _mm_set1_epi8(a), vb = _mm_set1_epi8(b), vc = _mm_set1_epi8(c);
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)p);
+        __m128i hit = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, va), _mm_cmpeq_epi8(v, vb)),
+                                   _mm_cmpeq_epi8(v, vc));
+        unsigned mask = (unsigned)_mm_movemask_epi8(hit);
+        if (mask) return p + lowestSetBit(mask);
+        p += 16;
+    }
+    return findAnyScalar(p, end, a, b, c);
+}
+
+TARGET_SSE2 void countSSE2(const char *p, const char *end, size_t &quotes, size_t &newlines) {
+    const __m128i vq = _mm_set1_epi8('"'), vn = _mm_set1_epi8('\n');
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)p);
+        quotes += bitset<16>((unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, vq))).count();
+        newlines += bitset<16>((unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, vn))).count();
+        p += 16;
+    }
+    countScalar(p, end, quotes, newlines);
+}
+
+TARGET_AVX2 const char *findAnyAVX2(const char *p, const char *end, char a, char b, char c) {
+    const __m256i va = _mm256_set1_epi8(a), vb = _mm256_set1_epi8(b), vc = _mm256_set1_epi8(c);
+    while (end - p >= 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)p);
+        __m256i hit = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, va), _mm256_cmpeq_epi8(v, vb)),
+                                      _mm256_cmpeq_epi8(v, vc));
+        unsigned mask = (unsigned)_mm256_movemask_epi8(hit);
+        if (mask) return p + lowestSetBit(mask);
+        p += 32;
+    }
+    // Finish the tail here rather than in findAnySSE2: mixing legacy SSE
+    // code into an AVX function costs a state transition on every call.
+    if (end - p >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)p);
+        __m128i hit = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm256_castsi256_si128(va)),
+                                                _mm_cmpeq_epi8(v, _mm256_castsi256_si128(vb))),
+                                   _mm_cmpeq_epi8(v, _mm256_castsi256_si128(vc)));
+        unsigned mask = (unsigned)_mm_movemask_epi8(hit);
+        if (mask) return p + lowestSetBit(mask);
+        p += 16;
+    }
+    return findAnyScalar(p, end, a, b, c);
+}
+
+TARGET_AVX2 void countAVX2(const char *p, const char *end, size_t &quotes, size_t &newlines) {
+    const __m256i vq = _mm256_set1_epi8('"'), vn = _mm256_set1_epi8('\n');
+    while (end - p >= 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)p);
+        quotes += bitset<32>((unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, vq))).count();
+        newlines += bitset<32>((unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, vn))).count();
+        p += 32;
+    }
+    countScalar(p, end, quotes, newlines);
+}
+
+bool cpuHasAVX2() {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    if (!osxsave || (_xgetbv(0) & 6) != 6) return false;   // OS must save YMM registers
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+const ScanKernels SCALAR_KERNELS = {"scalar", findAnyScalar, countScalar};
+
+ScanKernels pickScanKernels() {
+#ifdef TASKBOARD_X86
+    if (cpuHasAVX2()) return {"avx2", findAnyAVX2, countAVX2};
+    return {"sse2", findAnySSE2, countSSE2};
+#else
+    return SCALAR_KERNELS;
+#endif
+}
+
+ScanKernels scanKernels = pickScanKernels();
+
+vector<ScanKernels> availableScanKernels() {
+    vector<ScanKernels> kernels = {SCALAR_KERNELS};
+#ifdef TASKBOARD_X86
+    kernels.push_back({"sse2", findAnySSE2, countSSE2});
+    if (cpuHasAVX2()) kernels.push_back({"avx2", findAnyAVX2, countAVX2});
+#endif
+    return kernels;
+}
+
+vector<string> parseCSVLine(const string &line) {
+    vector<string> tokens;
+    string current;
+    bool inQuotes = false;
+    for (size_t i = 0; i < line.size(); ++i) {
+        char c = line[i];
+        if (inQuotes) {
+            if (c == '"') {
+                if (i + 1 < line.size() && line[i + 1] == '"') {
+                    current += '"';
+                    ++i;
+                } else {
+                    inQuotes = false;
+                }
+            } else {
+                current += c;
+            }
+        } else {
+            if (c == '"') {
+                inQuotes = true;
+            } else if (c == ',') {
+                tokens.push_back(current);
+                current.clear();
+            } else {
+                current += c;
+            }
+        }
+    }
+    tokens.push_back(current);
+    return tokens;
+}
+
+string csvEscape(const string &field) {
+    const char *p = field.data();
+    const char *end = p + field.size();
+    if (scanKernels.findAny(p, end, ',', '"', '\n') == end) return field;
+
+    string escaped;
+    escaped.reserve(field.size() + 8);
+    escaped += '"';
+    while (true) {
+        const char *q = scanKernels.findAny(p, end, '"', '"', '"');
+        escaped.append(p, q);
+        if (q == end) break;
+        escaped += "\"\"";
+        p = q + 1;
+    }
+    escaped += '"';
+    return escaped;
+}
+
+int getPriorityValue(uint32_t priority) {
+    if (priority == PRIORITY_HIGH) return 3;
+    if (priority == PRIORITY_MEDIUM) return 2;
+    if (priority == PRIORITY_LOW) return 1;
+    return 0;
+}
+
+
+// ---------- Scheduling heap ----------
+
+atomic<size_t> editCounter(0);
+
+void markChanged(ToDoList &list) {
+    list.version = list.shapeVersion = ++editCounter;
+    list.fieldVersions.clear();
+}
+
+// Whether two cells hold exactly the same value.
+bool sameCell(const Cell &a, const Cell &b) {
+    long long x = 0, y = 0;
+    bool dx = a.getDateMinutes(x), dy = b.getDateMinutes(y);
+    return a.type() == b.type() && a.getText() == b.getText() && a.getInt() == b.getInt() &&
+           a.getFloat() == b.getFloat() && a.getBool() == b.getBool() && dx == dy && x == y;
+}
+
+void markTaskChanged(ToDoList &list, const Task &before, const Task &after) {
+    list.version = ++editCounter;
+    auto touched = [&list](size_t field) {
+        if (list.fieldVersions.size() <= field) list.fieldVersions.resize(field + 1, 0);
+        list.fieldVersions[field] = list.version;
+    };
+    if (before.id != after.id) touched(FIELD_IDS);
+    if (before.name != after.name) touched(FIELD_NAMES);
+    if (before.priority != after.priority) touched(FIELD_PRIORITIES);
+    if (before.deadline != after.deadline || before.deadlineMinutes != after.deadlineMinutes) touched(FIELD_DEADLINES);
+    if (before.status != after.status) touched(FIELD_STATUSES);
+    size_t cells = max(before.extraColumns.size(), after.extraColumns.size());
+    for (size_t c = 0; c < cells; ++c) {
+        bool had = c < before.extraColumns.size(), has = c < after.extraColumns.size();
+        if (had != has || (had && !sameCell(before.extraColumns[c], after.extraColumns[c]))) touched(FIELD_EXTRAS + c);
+    }
+}
+
+// The version a field's columns must have been built at to be current.
+size_t fieldVersion(const ToDoList &list, size_t field) {
+    size_t v = list.shapeVersion;
+    if (field < list.fieldVersions.size()) v = max(v, list.fieldVersions[field]);
+    return v;
+}
+
+void buildExtraColumn(const ToDoList &list, size_t col, ExtraColumn &ec) {
+    ec.type = list.columnTypes[col];
+    ec.state.reserve(list.tasks.size());
+    for (const auto &t : list.tasks) {
+        bool present = col < t.extraColumns.size();
+        const Cell empty;
+        const Cell &c = present ? t.extraColumns[col] : empty;
+        bool isText = c.type() == DT_STRING || c.type() == DT_LINK;
+        bool native = present && (c.type() == ec.type || (isText && (ec.type == DT_STRING || ec.type == DT_LINK)));
+        ec.state.push_back(!present ? CELL_MISSING : native ? CELL_NATIVE : CELL_TEXT);
+        switch (ec.type) {
+            case DT_INT: ec.ints.push_back(c.getInt()); break;
+            case DT_FLOAT: ec.floats.push_back(c.getFloat()); break;
+            case DT_BOOL: ec.bools.push_back(c.getBool()); break;
+            case DT_DATE: {
+                long long minutes;
+                if (!native || !c.getDateMinutes(minutes)) minutes = LLONG_MAX;
+                ec.dates.push_back(minutes);
+                break;
+            }
+            case DT_STRING:
+            case DT_LINK:
+                ec.strings.push(c.getText());
+                break;
+        }
+    }
+}
+
+shared_ptr<FieldColumns> buildField(const ToDoList &list, size_t field) {
+    auto built = make_shared<FieldColumns>();
+    FieldColumns &fc = *built;
+    size_t n = list.tasks.size();
+    switch (field) {
+        case FIELD_IDS:
+            fc.ids.reserve(n);
+            for (const auto &t : list.tasks) fc.ids.push_back(t.id);
+            break;
+        case FIELD_NAMES:
+            for (const auto &t : list.tasks) fc.text.push(t.name);
+            break;
+        case FIELD_PRIORITIES:
+            fc.codes.reserve(n);
+            fc.flags.reserve(n);
+            for (const auto &t : list.tasks) {
+                fc.codes.push_back(t.priority);
+                fc.flags.push_back((uint8_t)getPriorityValue(t.priority));
+            }
+            break;
+        case FIELD_DEADLINES:
+            fc.minutes.reserve(n);
+            for (const auto &t : list.tasks) {
+                fc.text.push(t.deadline);
+                fc.minutes.push_back(t.deadlineMinutes);
+            }
+            break;
+        case FIELD_STATUSES:
+            fc.codes.reserve(n);
+            fc.flags.reserve(n);
+            for (const auto &t : list.tasks) {
+                fc.codes.push_back(t.status);
+                fc.flags.push_back(t.status == STATUS_COMPLETED);
+            }
+            break;
+        default:
+            buildExtraColumn(list, field - FIELD_EXTRAS, fc.extra);
+            break;
+    }
+    return built;
+}
+
+const FieldColumns &ColumnStore::field(size_t f) const {
+    ColumnCache &cache = list->columns;
+    size_t version = fieldVersion(*list, f);
+    {
+        lock_guard<mutex> guard(cache.lock);
+        if (f < cache.fields.size() && cache.fields[f] && cache.fields[f]->version == version) return *cache.fields[f];
+    }
+    shared_ptr<FieldColumns> built = buildField(*list, f);
+    built->version = version;
+    lock_guard<mutex> guard(cache.lock);
+    if (cache.fields.size() <= f) cache.fields.resize(f + 1);
+    // Another reader may have got there first; everyone uses the one that landed
+    if (!cache.fields[f] || cache.fields[f]->version != version) cache.fields[f] = move(built);
+    return *cache.fields[f];
+}
+
+ColumnStore columnsOf(const ToDoList &list) {
+    ColumnStore cols;
+    cols.list = &list;
+    cols.rows = list.tasks.size();
+    return cols;
+}
+
+void scheduleTask(ToDoList &list, const Task &t) {
+    if (t.status == STATUS_COMPLETED) {
+        list.schedule.remove(t.id);
+        list.dueIndex.remove(t.id);
+        return;
+    }
+    list.schedule.set({t.deadlineMinutes, getPriorityValue(t.priority), t.id});
+    if (t.deadlineMinutes == NO_DEADLINE) list.dueIndex.remove(t.id);
+    else list.dueIndex.update(t.id, t.deadlineMinutes);
+}
+
+void unscheduleTask(ToDoList &list, int id) {
+    list.schedule.remove(id);
+    list.dueIndex.remove(id);
+}
+
+void rebuildScheduleHeap(ToDoList &list) {
+    vector<ScheduleEntry> entries;
+    entries.reserve(list.tasks.size());
+    for (const auto &t : list.tasks)
+        if (t.status != STATUS_COMPLETED)
+            entries.push_back({t.deadlineMinutes, getPriorityValue(t.priority), t.id});
+    list.schedule.build(move(entries));
+}
+
+void rebuildDeadlineIndex(ToDoList &list, const vector<pair<long long, int>> *sorted) {
+    DeadlineIndex &index = list.dueIndex;
+    index.clear();
+    if (sorted != nullptr) {
+        index.deadlineOf.reserve(sorted->size());
+        for (const auto &d : *sorted) index.deadlineOf.emplace(d.second, d.first);
+        index.byDeadline = set<pair<long long, int>>(sorted->begin(), sorted->end());
+        return;
+    }
+    vector<pair<long long, int>> dated;
+    dated.reserve(list.tasks.size());
+    index.deadlineOf.reserve(list.tasks.size());
+    for (const auto &t : list.tasks) {
+        if (t.status == STATUS_COMPLETED || t.deadlineMinutes == NO_DEADLINE) continue;
+        if (index.deadlineOf.emplace(t.id, t.deadlineMinutes).second)
+            dated.push_back({t.deadlineMinutes, t.id});
+    }
+    sort(dated.begin(), dated.end());
+    index.byDeadline = set<pair<long long, int>>(dated.begin(), dated.end());
+}
+
+
+// ---------- Lookups ----------
+
+size_t findRow(const ToDoList &list, int id) {
+    auto it = list.rowOfId.find(id);
+    return it == list.rowOfId.end() ? NO_ROW : it->second;
+}
+
+int findColumn(const ToDoList &list, const string &name) {
+    auto it = list.columnOfName.find(name);
+    return it == list.columnOfName.end() ? -1 : (int)it->second;
+}
+
+void reindexRows(ToDoList &list) {
+    list.rowOfId.clear();
+    list.rowOfId.reserve(list.tasks.size());
+    for (size_t r = 0; r < list.tasks.size(); ++r)
+        list.rowOfId.emplace(list.tasks[r].id, r);
+}
+
+void reindexColumns(ToDoList &list) {
+    list.columnOfName.clear();
+    for (size_t i = 0; i < list.columnNames.size(); ++i)
+        list.columnOfName.emplace(list.columnNames[i], i);
+}
+
+const size_t PARALLEL_INDEX_MIN_ROWS = 1 << 16;
+
+void rebuildIndexes(ToDoList &list, const vector<pair<long long, int>> *sortedDeadlines) {
+    MetricTimer timer(METRIC_INDEX_REBUILD);
+    timer.rows = list.tasks.size();
+    reindexColumns(list);
+    auto build = [&list, sortedDeadlines](unsigned part) {
+        if (part == 0) reindexRows(list);
+        if (part == 1) rebuildScheduleHeap(list);
+        if (part == 2) rebuildDeadlineIndex(list, sortedDeadlines);
+    };
+    if (list.tasks.size() >= PARALLEL_INDEX_MIN_ROWS && thread::hardware_concurrency() > 1) {
+        runOnThreads(3, build);
+    } else {
+        for (unsigned part = 0; part < 3; ++part) build(part);
+    }
+    rebuildTextIndex(list);
+}
+
+
+// ---------- Journal ----------
+// With --journal <board>, every edit is also appended to board.tbj.<n> as
+// one small binary record, so nothing done since the last save is lost if
+// the program dies. At startup board.tbs (the last snapshot) is opened and
+// the records after it replayed; once a segment grows past
+// COMPACT_JOURNAL_BYTES it is folded into a new snapshot in the background.
+//
+// A record is [uint32 length][uint32 checksum][length bytes]: a JournalOp,
+// its operands, then the board's nextId afterwards. Records describe each
+// change going forward (undo included) and name priorities and statuses
+// by text, so replaying one doesn't depend on symbol codes.
+
+// A cell's kind byte in journal records and snapshots: its DataType, or
+// one of these.
+const uint8_t CELL_KIND_MISSING = 0xFF;     // row is shorter than the header
+const uint8_t CELL_KIND_DATE_TEXT = 0x10;   // DATE kept as typed (see Cell::setDate)
+
+// A cell as a kind byte plus a 64-bit value; the text kinds (STRING, LINK,
+// DATE_TEXT) keep their text in cell.getText() instead.
+uint8_t encodeCell(const Cell &cell, int64_t &value) {
+    value = 0;
+    switch (cell.type()) {
+        case DT_INT: value = cell.getInt(); break;
+        case DT_BOOL: value = cell.getBool(); break;
+        case DT_FLOAT: {
+            float f = cell.getFloat();
+            uint32_t bits;
+            memcpy(&bits, &f, sizeof(bits));
+            value = bits;
+            break;
+        }
+        case DT_DATE: {
+            long long m;
+            if (!cell.getText().empty() || !cell.getDateMinutes(m)) return CELL_KIND_DATE_TEXT;
+            value = m;
+            break;
+        }
+        default: break;
+    }
+    return (uint8_t)cell.type();
+}
+
+// The other way round; false for an unknown kind (or CELL_KIND_MISSING).
+bool decodeCell(uint8_t kind, int64_t value, string_view text, Cell &cell) {
+    switch (kind) {
+        case DT_INT: cell.setValue((int)value); return true;
+        case DT_STRING: cell.setValue(text); return true;
+        case DT_BOOL: cell.setValue(value != 0); return true;
+        case DT_FLOAT: {
+            uint32_t bits = (uint32_t)value;
+            float f;
+            memcpy(&f, &bits, sizeof(f));
+            cell.setValue(f);
+            return true;
+        }
+        case DT_DATE: cell.setDateMinutes(value); return true;
+        case DT_LINK: cell.setLink(text); return true;
+        case CELL_KIND_DATE_TEXT: cell.setDate(text); return true;
+    }
+    return false;
+}
+
+bool cellKindHasText(uint8_t kind) {
+    return kind == DT_STRING || kind == DT_LINK || kind == CELL_KIND_DATE_TEXT;
+}
+
+enum JournalOp : uint8_t {
+    JR_PUT_TASK = 1,      // row (the row count to append), task
+    JR_REMOVE_ROWS,       // count, rows ascending
+    JR_INSERT_ROWS,       // count, (row, task) with rows ascending
+    JR_INSERT_COLUMN,     // column, name, type, count, a cell per row
+    JR_DELETE_COLUMN,     // column
+    JR_DROP_LAST_COLUMN,  // undoing an added column
+    JR_REORDER,           // count, order: row i becomes old row order[i]
+    JR_REPLACE            // column count, (name, type)..., task count, tasks
+};
+
+const size_t COMPACT_JOURNAL_BYTES = 64u << 20;
+
+// FNV-1a, enough to spot a record torn by a crash mid-write.
+uint32_t journalChecksum(const char *p, size_t n) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < n; ++i) h = (h ^ (uint8_t)p[i]) * 16777619u;
+    return h;
+}
+
+struct JournalRecord {
+    string bytes;
+
+    explicit JournalRecord(JournalOp op) { u8(op); }
+    void u8(uint8_t v) { bytes.push_back((char)v); }
+    void u32(uint32_t v) { bytes.append((const char *)&v, sizeof(v)); }
+    void u64(uint64_t v) { bytes.append((const char *)&v, sizeof(v)); }
+    void text(string_view s) {
+        u32((uint32_t)s.size());
+        bytes.append(s.data(), s.size());
+    }
+    void cell(const Cell &c) {
+        int64_t value;
+        uint8_t kind = encodeCell(c, value);
+        u8(kind);
+        if (cellKindHasText(kind)) text(c.getText());
+        else u64((uint64_t)value);
+    }
+    void task(const ToDoList &list, const Task &t) {
+        u32((uint32_t)t.id);
+        text(t.name);
+        text(list.priorities.text(t.priority));
+        text(t.deadline);
+        u64((uint64_t)t.deadlineMinutes);
+        text(list.statuses.text(t.status));
+        u32((uint32_t)t.extraColumns.size());
+        for (const auto &c : t.extraColumns) cell(c);
+    }
+};
+
+// Queues a record for the flusher; syncJournal waits for it to be on disk.
+void appendJournal(Journal &journal, JournalRecord &record, int nextId) {
+    record.u32((uint32_t)nextId);
+    uint32_t header[2] = {(uint32_t)record.bytes.size(),
+                          journalChecksum(record.bytes.data(), record.bytes.size())};
+    {
+        lock_guard<mutex> guard(journal.lock);
+        journal.pending.append((const char *)header, sizeof(header));
+        journal.pending.append(record.bytes);
+        ++journal.appended;
+    }
+    journal.wake.notify_one();
+}
+
+
+// ---------- Undo ----------
+
+UndoStep makeUndoStep(UndoKind kind, const ToDoList &list) {
+    UndoStep step;
+    step.kind = kind;
+    step.nextId = list.nextId;
+    return step;
+}
+
+size_t approxBytes(const Task &t) {
+    return sizeof(Task) + t.name.capacity() + t.deadline.capacity() + t.extraColumns.capacity() * sizeof(Cell);
+}
+
+size_t approxBytes(const UndoStep &step) {
+    size_t bytes = sizeof(UndoStep) + step.rows.capacity() * sizeof(size_t)
+                 + step.cells.capacity() * sizeof(Cell) + step.hadCell.capacity();
+    for (const auto &t : step.tasks) bytes += approxBytes(t);
+    if (step.previous)
+        for (const auto &t : step.previous->tasks) bytes += approxBytes(t);
+    return bytes;
+}
+
+void pushUndo(UndoLog &undo, UndoStep step) {
+    step.bytes = approxBytes(step);
+    if (step.bytes > undo.budgetBytes) {
+        undo.steps.clear();
+        undo.bytes = 0;
+        if (undo.warn)
+            undo.warn("This change is too large to undo (limit " + to_string(undo.budgetBytes >> 20) +
+                      " MB, see --undo-mb); undo history cleared.");
+        return;
+    }
+    undo.bytes += step.bytes;
+    undo.steps.push_back(move(step));
+    while (undo.steps.size() > undo.maxSteps || undo.bytes > undo.budgetBytes) {
+        undo.bytes -= undo.steps.front().bytes;
+        undo.steps.pop_front();
+    }
+}
+
+
+// ---------- Journal records for edits ----------
+
+void journalBoard(JournalRecord &record, const ToDoList &list) {
+    record.u32((uint32_t)list.columnNames.size());
+    for (size_t c = 0; c < list.columnNames.size(); ++c) {
+        record.text(list.columnNames[c]);
+        record.u8((uint8_t)list.columnTypes[c]);
+    }
+    record.u64(list.tasks.size());
+    for (const auto &t : list.tasks) record.task(list, t);
+}
+
+// Column `column` of every row, or CELL_KIND_MISSING where has(r) is false.
+template <class F>
+void journalColumn(JournalRecord &record, const ToDoList &list, size_t column, F &&has) {
+    record.u64(column);
+    record.text(list.columnNames[column]);
+    record.u8((uint8_t)list.columnTypes[column]);
+    record.u64(list.tasks.size());
+    for (size_t r = 0; r < list.tasks.size(); ++r) {
+        if (has(r)) record.cell(list.tasks[r].extraColumns[column]);
+        else record.u8(CELL_KIND_MISSING);
+    }
+}
+
+void journalRows(JournalRecord &record, const vector<size_t> &rows) {
+    record.u64(rows.size());
+    for (size_t r : rows) record.u64(r);
+}
+
+// The edit `step` was recorded for, read back from the board after it.
+JournalRecord editRecord(const ToDoList &list, const UndoStep &step) {
+    switch (step.kind) {
+        case UNDO_ADD_TASK:
+        case UNDO_UPDATE_TASK: {
+            size_t row = step.kind == UNDO_ADD_TASK ? list.tasks.size() - 1 : step.rows[0];
+            JournalRecord record(JR_PUT_TASK);
+            record.u64(row);
+            record.task(list, list.tasks[row]);
+            return record;
+        }
+        case UNDO_ADD_TASKS: {
+            JournalRecord record(JR_INSERT_ROWS);
+            record.u64(step.rows.size());
+            for (size_t r : step.rows) {
+                record.u64(r);
+                record.task(list, list.tasks[r]);
+            }
+            return record;
+        }
+        case UNDO_REMOVE_ROWS: {
+            JournalRecord record(JR_REMOVE_ROWS);
+            journalRows(record, step.rows);
+            return record;
+        }
+        case UNDO_ADD_COLUMN: {
+            // addColumn appended a cell to every row
+            JournalRecord record(JR_INSERT_COLUMN);
+            size_t column = list.columnNames.size() - 1;
+            record.u64(column);
+            record.text(list.columnNames[column]);
+            record.u8((uint8_t)list.columnTypes[column]);
+            record.u64(list.tasks.size());
+            for (const auto &t : list.tasks) {
+                if (t.extraColumns.empty()) record.u8(CELL_KIND_MISSING);
+                else record.cell(t.extraColumns.back());
+            }
+            return record;
+        }
+        case UNDO_DELETE_COLUMN: {
+            JournalRecord record(JR_DELETE_COLUMN);
+            record.u64(step.column);
+            return record;
+        }
+        case UNDO_REORDER: {
+            JournalRecord record(JR_REORDER);
+            journalRows(record, step.rows);
+            return record;
+        }
+        case UNDO_REPLACE_LIST:
+            break;
+    }
+    JournalRecord record(JR_REPLACE);
+    journalBoard(record, list);
+    return record;
+}
+
+// What undoing `step` did, read back from the board after the undo.
+JournalRecord undoneRecord(const ToDoList &list, const UndoStep &step) {
+    switch (step.kind) {
+        case UNDO_ADD_TASK: {
+            JournalRecord record(JR_REMOVE_ROWS);
+            journalRows(record, {list.tasks.size()});
+            return record;
+        }
+        case UNDO_ADD_TASKS: {
+            JournalRecord record(JR_REMOVE_ROWS);
+            journalRows(record, step.rows);
+            return record;
+        }
+        case UNDO_UPDATE_TASK: {
+            JournalRecord record(JR_PUT_TASK);
+            record.u64(step.rows[0]);
+            record.task(list, list.tasks[step.rows[0]]);
+            return record;
+        }
+        case UNDO_REMOVE_ROWS: {
+            JournalRecord record(JR_INSERT_ROWS);
+            record.u64(step.rows.size());
+            for (size_t r : step.rows) {
+                record.u64(r);
+                record.task(list, list.tasks[r]);
+            }
+            return record;
+        }
+        case UNDO_ADD_COLUMN:
+            return JournalRecord(JR_DROP_LAST_COLUMN);
+        case UNDO_DELETE_COLUMN: {
+            JournalRecord record(JR_INSERT_COLUMN);
+            journalColumn(record, list, step.column, [&step](size_t r) { return step.hadCell[r] != 0; });
+            return record;
+        }
+        case UNDO_REORDER: {
+            vector<size_t> inverse(step.rows.size());
+            for (size_t i = 0; i < step.rows.size(); ++i) inverse[step.rows[i]] = i;
+            JournalRecord record(JR_REORDER);
+            journalRows(record, inverse);
+            return record;
+        }
+        case UNDO_REPLACE_LIST:
+            break;
+    }
+    JournalRecord record(JR_REPLACE);
+    journalBoard(record, list);
+    return record;
+}
+
+void recordEdit(const ToDoList &list, UndoLog &undo, UndoStep step) {
+    MetricTimer timer(METRIC_UNDO_RECORD);
+    timer.rows = step.rows.size();
+    if (undo.journal != nullptr) {
+        JournalRecord record = editRecord(list, step);
+        appendJournal(*undo.journal, record, list.nextId);
+    }
+    pushUndo(undo, move(step));
+    if (!undo.steps.empty()) timer.bytesOut = undo.steps.back().bytes;
+}
+
+void applyRowOrder(ToDoList &list, const vector<size_t> &order) {
+    vector<Task> sorted;
+    sorted.reserve(order.size());
+    for (size_t r : order) sorted.push_back(move(list.tasks[r]));
+    list.tasks.swap(sorted);
+    reindexRows(list);
+    markChanged(list);
+}
+
+void removeRows(ToDoList &list, const vector<size_t> &rows, UndoLog &undo) {
+    UndoStep step = makeUndoStep(UNDO_REMOVE_ROWS, list);
+    step.rows = rows;
+    step.tasks.reserve(rows.size());
+    size_t kept = 0, next = 0;
+    for (size_t r = 0; r < list.tasks.size(); ++r) {
+        if (next < rows.size() && rows[next] == r) {
+            unindexTaskText(list, list.tasks[r].id);
+            step.tasks.push_back(move(list.tasks[r]));
+            ++next;
+            continue;
+        }
+        if (kept != r) list.tasks[kept] = move(list.tasks[r]);
+        ++kept;
+    }
+    list.tasks.erase(list.tasks.begin() + kept, list.tasks.end());
+    reindexRows(list);
+    compactTextIndex(list);
+    recordEdit(list, undo, move(step));
+}
+
+void replaceList(ToDoList &list, ToDoList &&next, UndoLog &undo) {
+    UndoStep step = makeUndoStep(UNDO_REPLACE_LIST, list);
+    step.previous = make_shared<ToDoList>(move(list));
+    list = move(next);
+    if (step.previous->text.enabled) enableTextIndex(list);
+    recordEdit(list, undo, move(step));
+}
+
+bool undoLast(ToDoList &list, UndoLog &undo) {
+    if (undo.steps.empty()) return false;
+    MetricTimer timer(METRIC_UNDO);
+    timer.bytesIn = undo.steps.back().bytes;
+    UndoStep step = move(undo.steps.back());
+    undo.steps.pop_back();
+    undo.bytes -= step.bytes;
+
+    switch (step.kind) {
+        case UNDO_ADD_TASK: {
+            int id = list.tasks.back().id;
+            unscheduleTask(list, id);
+            unindexTaskText(list, id);
+            if (findRow(list, id) == list.tasks.size() - 1) list.rowOfId.erase(id);
+            list.tasks.pop_back();
+            compactTextIndex(list);
+            break;
+        }
+        case UNDO_ADD_TASKS:
+            for (size_t r : step.rows) {
+                int id = list.tasks[r].id;
+                unscheduleTask(list, id);
+                unindexTaskText(list, id);
+                if (findRow(list, id) == r) list.rowOfId.erase(id);
+            }
+            if (!step.rows.empty()) list.tasks.resize(step.rows.front());
+            compactTextIndex(list);
+            break;
+        case UNDO_UPDATE_TASK: {
+            Task &task = list.tasks[step.rows[0]];
+            swap(task, step.tasks[0]);
+            scheduleTask(list, task);
+            indexTaskText(list, task);
+            markTaskChanged(list, step.tasks[0], task);
+            break;
+        }
+        case UNDO_REMOVE_ROWS: {
+            // Merge the removed rows back in at their old positions.
+            vector<Task> merged;
+            merged.reserve(list.tasks.size() + step.tasks.size());
+            size_t src = 0;
+            for (size_t i = 0; i < step.rows.size(); ++i) {
+                while (merged.size() < step.rows[i]) merged.push_back(move(list.tasks[src++]));
+                merged.push_back(move(step.tasks[i]));
+                scheduleTask(list, merged.back());
+            }
+            while (src < list.tasks.size()) merged.push_back(move(list.tasks[src++]));
+            list.tasks.swap(merged);
+            reindexRows(list);
+            for (size_t r : step.rows) indexTaskText(list, list.tasks[r]);
+            break;
+        }
+        case UNDO_ADD_COLUMN: {
+            bool text = list.columnTypes.back() == DT_STRING;
+            list.columnNames.pop_back();
+            list.columnTypes.pop_back();
+            for (auto &t : list.tasks)
+                if (!t.extraColumns.empty()) t.extraColumns.pop_back();
+            reindexColumns(list);
+            if (text) rebuildTextIndex(list);
+            break;
+        }
+        case UNDO_DELETE_COLUMN:
+            list.columnNames.insert(list.columnNames.begin() + step.column, step.columnName);
+            list.columnTypes.insert(list.columnTypes.begin() + step.column, step.columnType);
+            for (size_t r = 0; r < list.tasks.size(); ++r) {
+                if (!step.hadCell[r]) continue;
+                auto &cells = list.tasks[r].extraColumns;
+                cells.insert(cells.begin() + step.column, move(step.cells[r]));
+            }
+            reindexColumns(list);
+            if (step.columnType == DT_STRING) rebuildTextIndex(list);
+            break;
+        case UNDO_REORDER: {
+            vector<size_t> inverse(step.rows.size());
+            for (size_t i = 0; i < step.rows.size(); ++i) inverse[step.rows[i]] = i;
+            applyRowOrder(list, inverse);
+            break;
+        }
+        case UNDO_REPLACE_LIST: {
+            bool text = list.text.enabled;
+            list = move(*step.previous);
+            if (text) enableTextIndex(list);
+            break;
+        }
+    }
+    list.nextId = step.nextId;
+    if (step.kind != UNDO_UPDATE_TASK) markChanged(list);
+    if (undo.journal != nullptr) {
+        JournalRecord record = undoneRecord(list, step);
+        appendJournal(*undo.journal, record, list.nextId);
+    }
+    return true;
+}
+
+
+// ---------- Editing ----------
+
+void appendTasks(ToDoList &list, UndoLog &undo, vector<Task> &&batch) {
+    MetricTimer timer(METRIC_ADD_TASKS);
+    timer.rows = batch.size();
+    UndoStep step = makeUndoStep(UNDO_ADD_TASKS, list);
+    size_t first = list.tasks.size();
+    list.tasks.reserve(first + batch.size());
+    for (auto &t : batch) {
+        t.id = list.nextId++;
+        list.tasks.push_back(move(t));
+    }
+    step.rows.resize(batch.size());
+    iota(step.rows.begin(), step.rows.end(), first);
+    if (batch.size() * 4 >= list.tasks.size()) {
+        reindexRows(list);
+        rebuildScheduleHeap(list);
+        rebuildDeadlineIndex(list);
+    } else {
+        list.rowOfId.reserve(list.tasks.size());
+        for (size_t r = first; r < list.tasks.size(); ++r) {
+            list.rowOfId.emplace(list.tasks[r].id, r);
+            scheduleTask(list, list.tasks[r]);
+        }
+    }
+    for (size_t r = first; r < list.tasks.size(); ++r) indexTaskText(list, list.tasks[r]);
+    recordEdit(list, undo, move(step));
+    markChanged(list);
+}
+
+bool deleteTaskById(ToDoList &list, UndoLog &undo, int id) {
+    size_t first = findRow(list, id);
+    if (first == NO_ROW) return false;
+    MetricTimer timer(METRIC_REMOVE_ROWS);
+    // Rows at or after the first one, in case the id repeats.
+    vector<size_t> rows;
+    for (size_t r = first; r < list.tasks.size(); ++r)
+        if (list.tasks[r].id == id) rows.push_back(r);
+    timer.rows = rows.size();
+    removeRows(list, rows, undo);
+    unscheduleTask(list, id);
+    markChanged(list);
+    return true;
+}
+
+bool deleteColumnByName(ToDoList &list, UndoLog &undo, const string &colName) {
+    int index = findColumn(list, colName);
+    if (index < 0) return false;
+    MetricTimer timer(METRIC_COLUMNS);
+    timer.rows = list.tasks.size();
+
+    UndoStep step = makeUndoStep(UNDO_DELETE_COLUMN, list);
+    step.column = index;
+    step.columnName = colName;
+    step.columnType = list.columnTypes[index];
+    step.cells.resize(list.tasks.size());
+    step.hadCell.resize(list.tasks.size());
+
+    // Remove from structure
+    list.columnNames.erase(list.columnNames.begin() + index);
+    list.columnTypes.erase(list.columnTypes.begin() + index);
+    reindexColumns(list);
+
+    for (size_t r = 0; r < list.tasks.size(); ++r) {
+        auto &cells = list.tasks[r].extraColumns;
+        if ((size_t)index >= cells.size()) continue;  // short row
+        step.cells[r] = move(cells[index]);
+        step.hadCell[r] = 1;
+        cells.erase(cells.begin() + index);
+    }
+    if (step.columnType == DT_STRING) rebuildTextIndex(list);
+    recordEdit(list, undo, move(step));
+    markChanged(list);
+    return true;
+}
+
+size_t removeCompleted(ToDoList &list, UndoLog &undo) {
+    MetricTimer timer(METRIC_REMOVE_ROWS);
+    const vector<uint8_t> &completed = columnsOf(list).completed();
+    vector<size_t> rows;
+    for (size_t r = 0; r < completed.size(); ++r)
+        if (completed[r]) rows.push_back(r);
+    timer.rows = rows.size();
+    if (!rows.empty()) {
+        removeRows(list, rows, undo);
+        // Completed tasks are never in the scheduling heap or deadline
+        // index, so neither needs a change.
+        markChanged(list);
+    }
+    return rows.size();
+}
+
+bool setTypedCell(Cell &c, DataType type, string_view text, string &error) {
+    int i;
+    float f;
+    bool b;
+    long long minutes;
+    bool fits = text.empty() || type == DT_STRING || type == DT_LINK ||
+                (type == DT_INT && parseIntText(text, i)) ||
+                (type == DT_FLOAT && parseFloatText(text, f)) ||
+                (type == DT_BOOL && parseBoolText(text, b)) ||
+                (type == DT_DATE && parseDateTime(text, minutes));
+    if (!fits) {
+        error = "'" + string(text) + "' is not a valid " + dataTypeName(type);
+        return false;
+    }
+    if (text.empty()) c.setValue(text);
+    else setCellFromText(c, type, text);
+    return true;
+}
+
+bool updateTaskField(ToDoList &list, UndoLog &undo, int id, const string &column, string_view value,
+                     string &error) {
+    size_t row = findRow(list, id);
+    if (row == NO_ROW) {
+        error = "no task with id " + to_string(id);
+        return false;
+    }
+    Task updated = list.tasks[row];
+    bool textChanged = column == "TaskName";
+    if (column == "TaskName") {
+        updated.name = value;
+    } else if (column == "Priority") {
+        updated.priority = list.priorities.intern(value);
+    } else if (column == "Deadline") {
+        if (!setDeadline(updated, value)) {
+            error = "invalid deadline '" + string(value) + "' (use dd/mm/yyyy hh:mm)";
+            return false;
+        }
+    } else if (column == "Status") {
+        updated.status = list.statuses.intern(value);
+    } else {
+        int i = findColumn(list, column);
+        if (i < 0) {
+            error = "no column '" + column + "'";
+            return false;
+        }
+        if ((size_t)i >= updated.extraColumns.size()) updated.extraColumns.resize(i + 1);
+        if (!setTypedCell(updated.extraColumns[i], list.columnTypes[i], value, error)) return false;
+        textChanged = list.columnTypes[i] == DT_STRING;
+    }
+
+    UndoStep step = makeUndoStep(UNDO_UPDATE_TASK, list);
+    step.rows.push_back(row);
+    step.tasks.push_back(move(list.tasks[row]));
+    list.tasks[row] = move(updated);
+    scheduleTask(list, list.tasks[row]);
+    if (textChanged) indexTaskText(list, list.tasks[row]);
+    markTaskChanged(list, step.tasks[0], list.tasks[row]);
+    recordEdit(list, undo, move(step));
+    return true;
+}
+
+bool addColumnWithValue(ToDoList &list, UndoLog &undo, const string &name, DataType type, string_view value,
+                        string &error) {
+    Cell c;
+    if (!setTypedCell(c, type, value, error)) return false;
+    return addColumnWithCells(list, undo, name, type, vector<Cell>(list.tasks.size(), c), error);
+}
+
+bool addColumnWithCells(ToDoList &list, UndoLog &undo, const string &name, DataType type, vector<Cell> cells,
+                        string &error) {
+    if (name.empty()) {
+        error = "column name is empty";
+        return false;
+    }
+    if (findColumn(list, name) >= 0) {
+        error = "column '" + name + "' already exists";
+        return false;
+    }
+    if (type < DT_INT || type > DT_LINK || cells.size() != list.tasks.size()) {
+        error = "bad column type or cell count";
+        return false;
+    }
+    MetricTimer timer(METRIC_COLUMNS);
+    timer.rows = list.tasks.size();
+    list.columnNames.push_back(name);
+    list.columnTypes.push_back(type);
+    list.columnOfName.emplace(name, list.columnNames.size() - 1);
+    for (size_t r = 0; r < list.tasks.size(); ++r) list.tasks[r].extraColumns.push_back(move(cells[r]));
+    if (type == DT_STRING) rebuildTextIndex(list);
+    recordEdit(list, undo, makeUndoStep(UNDO_ADD_COLUMN, list));
+    markChanged(list);
+    return true;
+}
+
+
+// ---------- CSV files ----------
+
+bool writeCSV(const ToDoList &list, const string &path) {
+    MetricTimer timer(METRIC_CSV_WRITE);
+    timer.rows = list.tasks.size();
+    ofstream out(path);
+    if (!out) return false;
+    out << "ID,Name,Priority,Deadline,Status";
+    for (auto col : list.columnNames) out << "," << csvEscape(col);
+    out << "\n";
+    // Type row, so a reload gets INT/FLOAT/BOOL/DATE columns back as-is
+    out << CSV_TYPE_ROW_MARKER << ",STRING,STRING,DATE,STRING";
+    for (auto type : list.columnTypes) out << "," << dataTypeName(type);
+    out << "\n";
+
+    for (auto &t : list.tasks) {
+        out << t.id << "," << csvEscape(t.name) << "," << csvEscape(list.priorities.text(t.priority)) << ","
+            << csvEscape(t.deadline) << "," << csvEscape(list.statuses.text(t.status));
+        for (auto &cell : t.extraColumns)
+            out << "," << csvEscape(cell.getAsString());
+        out << "\n";
+    }
+    timer.bytesOut = (uint64_t)max<streamoff>(0, out.tellp());
+    out.close();
+    return (bool)out;
+}
+
+// Reads a type row (see CSV_TYPE_ROW_MARKER) into one type per extra
+// column. Returns false if `fields` isn't a type row.
+bool parseTypeRow(const vector<string> &fields, size_t columnCount, vector<DataType> &types) {
+    if (fields.empty() || fields[0] != CSV_TYPE_ROW_MARKER) return false;
+    types.assign(columnCount, DT_STRING);
+    for (size_t i = 0; i < columnCount && i + 5 < fields.size(); ++i) {
+        if (!parseDataTypeName(fields[i + 5], types[i])) types[i] = DT_STRING;
+    }
+    return true;
+}
+
+// Turns string cells loaded from CSV into native cells of `types`.
+void convertLoadedColumns(ToDoList &list, const vector<DataType> &types) {
+    for (size_t col = 0; col < types.size(); ++col) {
+        list.columnTypes[col] = types[col];
+        if (types[col] == DT_STRING) continue;
+        for (auto &task : list.tasks) {
+            if (col >= task.extraColumns.size()) continue;
+            Cell &c = task.extraColumns[col];
+            string text(c.getText());
+            setCellFromText(c, types[col], text);
+        }
+    }
+}
+
+// Guesses each extra column's type from the first TYPE_SAMPLE_ROWS tasks.
+vector<DataType> inferLoadedColumnTypes(const ToDoList &list) {
+    vector<ColumnTypeGuess> guesses(list.columnNames.size());
+    size_t rows = min(list.tasks.size(), TYPE_SAMPLE_ROWS);
+    for (size_t r = 0; r < rows; ++r) {
+        const Task &t = list.tasks[r];
+        for (size_t col = 0; col < guesses.size() && col < t.extraColumns.size(); ++col)
+            guesses[col].add(t.extraColumns[col].getText());
+    }
+    vector<DataType> types;
+    for (const auto &g : guesses) types.push_back(g.result());
+    return types;
+}
+
+void readCSVStream(ToDoList &fresh, istream &in, bool inferTypes, CSVLoadStats &stats) {
+    MetricTimer timer(METRIC_CSV_READ);
+    string line;
+    getline(in, line);
+    timer.bytesIn += line.size() + 1;
+
+    // Extract all column names
+    vector<string> headers = parseCSVLine(line);
+
+    // First 5 columns are standard fields and the rest are extra columns
+    fresh.columnNames.clear();
+    fresh.columnTypes.clear();
+    for (size_t i = 5; i < headers.size(); ++i) {
+        fresh.columnNames.push_back(headers[i]);
+        fresh.columnTypes.push_back(DT_STRING); // Default all loaded columns to string
+    }
+    
+    fresh.tasks.clear();
+    fresh.priorities = prioritySymbols();
+    fresh.statuses = statusSymbols();
+    vector<DataType> fileTypes;
+    bool hasTypeRow = false;
+    bool firstRow = true;
+    while (getline(in, line)) {
+        timer.bytesIn += line.size() + 1;
+        if (line.empty()) continue;
+        vector<string> tokens = parseCSVLine(line);
+
+        if (firstRow) {
+            firstRow = false;
+            hasTypeRow = parseTypeRow(tokens, fresh.columnNames.size(), fileTypes);
+            if (hasTypeRow) continue;
+        }
+        if (tokens.size() < 5) continue;
+
+        Task t;
+        try {
+            t.id = stoi(tokens[0]);
+        } catch (...) {
+            stats.malformedRows.push_back(line);
+            ++stats.skipped;
+            continue;
+        }
+        t.name = tokens[1];
+        t.priority = fresh.priorities.intern(tokens[2]);
+        setDeadline(t, tokens[3]);
+        t.status = fresh.statuses.intern(tokens[4]);
+
+        for (size_t i = 5; i < tokens.size(); ++i) {
+            Cell c;
+            c.setValue(tokens[i]);
+            t.extraColumns.push_back(c);
+        }
+
+        fresh.tasks.push_back(t);
+    }
+
+    int maxId = 0;
+    for (const auto& t : fresh.tasks) {
+        if (t.id > maxId) maxId = t.id;
+    }
+    fresh.nextId = maxId + 1;
+
+    if (hasTypeRow) convertLoadedColumns(fresh, fileTypes);
+    else if (inferTypes) convertLoadedColumns(fresh, inferLoadedColumnTypes(fresh));
+    timer.rows = stats.rows = fresh.tasks.size();
+    stats.bytes = timer.bytesIn;
+    rebuildIndexes(fresh);
+    markChanged(fresh);
+}
+
+// Read-only view of a whole file mapped into memory. The OS pages it in
+// on demand, so even huge boards never get copied into our own buffers.
+struct MappedFile {
+    const char *data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = NULL;
+#else
+    int fd = -1;
+#endif
+
+    MappedFile() {}
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    ~MappedFile() { close(); }
+
+    bool open(const string &path) {
+        close();
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                           OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        if (file == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER len;
+        if (!GetFileSizeEx(file, &len)) { close(); return false; }
+        size = (size_t)len.QuadPart;
+        if (size == 0) { data = ""; return true; }   // can't map an empty file
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping == NULL) { close(); return false; }
+        data = (const char *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (data == nullptr) { close(); return false; }
+#else
+        fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0) { close(); return false; }
+        size = (size_t)st.st_size;
+        if (size == 0) { data = ""; return true; }   // can't map an empty file
+        void *p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) { close(); return false; }
+        data = (const char *)p;
+        madvise(p, size, MADV_SEQUENTIAL);
+#endif
+        return true;
+    }
+
+    void close() {
+#ifdef _WIN32
+        if (data != nullptr && size > 0) UnmapViewOfFile(data);
+        if (mapping != NULL) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+        mapping = NULL;
+        file = INVALID_HANDLE_VALUE;
+#else
+        if (data != nullptr && size > 0) munmap((void *)data, size);
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+#endif
+        data = nullptr;
+        size = 0;
+    }
+};
+
+void assignCSVField(string &out, const CSVField &field) {
+    if (!field.needsUnescape) {
+        out.assign(field.text.data(), field.text.size());
+        return;
+    }
+    out.clear();
+    out.reserve(field.text.size());
+    string_view s = field.text;
+    bool inQuotes = false;
+    for (size_t i = 0; i < s.size(); ++i) {
+        char c = s[i];
+        if (c != '"') {
+            out += c;
+        } else if (inQuotes && i + 1 < s.size() && s[i + 1] == '"') {
+            out += '"';
+            ++i;
+        } else {
+            inQuotes = !inQuotes;
+        }
+    }
+}
+
+const char *parseCSVRecord(const char *p, const char *end, vector<CSVField> &fields) {
+    fields.clear();
+    const char *fieldStart = p;
+    bool inQuotes = false;
+    bool sawQuote = false;
+
+    auto finishField = [&](const char *fieldEnd) {
+        CSVField f;
+        size_t len = fieldEnd - fieldStart;
+        if (!sawQuote) {
+            f.text = string_view(fieldStart, len);
+        } else if (len >= 2 && fieldStart[0] == '"' && fieldEnd[-1] == '"' &&
+                   memchr(fieldStart + 1, '"', len - 2) == nullptr) {
+            f.text = string_view(fieldStart + 1, len - 2);   // simple "quoted" field
+        } else {
+            f.text = string_view(fieldStart, len);
+            f.needsUnescape = true;
+        }
+        fields.push_back(f);
+    };
+
+    while (p < end) {
+        if (inQuotes) {
+            // Inside quotes only another quote matters. A "" escape closes
+            // and immediately reopens, so the state still comes out right.
+            p = scanKernels.findAny(p, end, '"', '"', '"');
+            if (p == end) break;
+            inQuotes = false;
+            ++p;
+            continue;
+        }
+        p = scanKernels.findAny(p, end, '"', ',', '\n');
+        if (p == end) break;
+        char c = *p;
+        if (c == '"') {
+            inQuotes = true;
+            sawQuote = true;
+        } else if (c == ',') {
+            finishField(p);
+            fieldStart = p + 1;
+            sawQuote = false;
+        } else {
+            const char *fieldEnd = (p > fieldStart && p[-1] == '\r') ? p - 1 : p;
+            finishField(fieldEnd);
+            return p + 1;
+        }
+        ++p;
+    }
+    const char *fieldEnd = (p > fieldStart && p[-1] == '\r') ? p - 1 : p;
+    finishField(fieldEnd);
+    return p;
+}
+
+// Parses a task ID the way stoi would (leading spaces, trailing junk ignored).
+bool parseCSVInt(string_view s, int &out) {
+    size_t i = 0;
+    while (i < s.size() && (s[i] == ' ' || s[i] == '\t')) ++i;
+    if (i < s.size() && s[i] == '+') ++i;
+    auto res = from_chars(s.data() + i, s.data() + s.size(), out);
+    return res.ec == errc();
+}
+
+// Rows parsed by one loader thread, kept in file order so the chunks can
+// simply be appended one after another once every thread is done.
+struct CSVChunk {
+    const char *begin = nullptr;
+    const char *end = nullptr;
+    vector<Task> tasks;
+    vector<string> malformedRows;
+    size_t skipped = 0;
+    int maxId = 0;
+    // Codes are local to the chunk until the merge maps them to the list's.
+    SymbolTable priorities = prioritySymbols();
+    SymbolTable statuses = statusSymbols();
+};
+
+// Parses every record that starts inside [chunk.begin, chunk.end).
+// The last record may run past chunk.end; the next chunk starts right
+// after it, so no record is parsed twice or missed.
+void parseCSVChunk(CSVChunk &chunk, const vector<DataType> &types, size_t expectedRows) {
+    vector<CSVField> fields;
+    string scratch;
+    chunk.tasks.reserve(expectedRows);
+    const char *p = chunk.begin;
+
+    while (p < chunk.end) {
+        const char *recordStart = p;
+        p = parseCSVRecord(p, chunk.end, fields);
+        if (fields.size() == 1 && fields[0].text.empty()) continue;   // blank line
+        if (fields.size() < 5) { ++chunk.skipped; continue; }
+
+        int id;
+        if (!parseCSVInt(fields[0].text, id)) {
+            string_view rec(recordStart, p - recordStart);
+            while (!rec.empty() && (rec.back() == '\n' || rec.back() == '\r')) rec.remove_suffix(1);
+            chunk.malformedRows.push_back(string(rec));
+            ++chunk.skipped;
+            continue;
+        }
+
+        chunk.tasks.emplace_back();
+        Task &t = chunk.tasks.back();
+        t.id = id;
+        assignCSVField(t.name, fields[1]);
+        if (fields[2].needsUnescape) {
+            assignCSVField(scratch, fields[2]);
+            t.priority = chunk.priorities.intern(scratch);
+        } else {
+            t.priority = chunk.priorities.intern(fields[2].text);
+        }
+        if (fields[3].needsUnescape) {
+            assignCSVField(scratch, fields[3]);
+            setDeadline(t, scratch);
+        } else {
+            setDeadline(t, fields[3].text);
+        }
+        if (fields[4].needsUnescape) {
+            assignCSVField(scratch, fields[4]);
+            t.status = chunk.statuses.intern(scratch);
+        } else {
+            t.status = chunk.statuses.intern(fields[4].text);
+        }
+
+        t.extraColumns.resize(fields.size() - 5);
+        for (size_t i = 5; i < fields.size(); ++i) {
+            Cell &c = t.extraColumns[i - 5];
+            DataType type = i - 5 < types.size() ? types[i - 5] : DT_STRING;
+            if (!fields[i].needsUnescape) {
+                setCellFromText(c, type, fields[i].text);   // straight from the mapping
+            } else {
+                assignCSVField(scratch, fields[i]);
+                setCellFromText(c, type, scratch);
+            }
+        }
+
+        // nextId comes out of the same pass instead of a second scan
+        if (id > chunk.maxId) chunk.maxId = id;
+    }
+}
+
+// Below this much data, starting threads costs more than it saves.
+const size_t PARALLEL_LOAD_MIN_BYTES = 4 << 20;
+
+bool loadCSVMapped(ToDoList &list, const string &path, CSVLoadStats &stats,
+                   bool inferTypes, unsigned threads) {
+    MetricTimer timer(METRIC_CSV_READ_MAPPED);
+    auto start = chrono::steady_clock::now();
+    MappedFile file;
+    if (!file.open(path)) return false;
+
+    const char *p = file.data;
+    const char *end = file.data + file.size;
+    vector<CSVField> fields;
+
+    // Header: first 5 columns are standard fields and the rest are extra columns
+    p = parseCSVRecord(p, end, fields);
+    list.columnNames.clear();
+    list.columnTypes.clear();
+    for (size_t i = 5; i < fields.size(); ++i) {
+        string col;
+        assignCSVField(col, fields[i]);
+        list.columnNames.push_back(col);
+        list.columnTypes.push_back(DT_STRING); // Default all loaded columns to string
+    }
+
+    const char *afterTypeRow = parseCSVRecord(p, end, fields);
+    if (!fields.empty() && fields[0].text == CSV_TYPE_ROW_MARKER) {
+        for (size_t i = 0; i < list.columnTypes.size() && i + 5 < fields.size(); ++i) {
+            if (!parseDataTypeName(fields[i + 5].text, list.columnTypes[i])) list.columnTypes[i] = DT_STRING;
+        }
+        p = afterTypeRow;
+    } else if (inferTypes) {
+        vector<ColumnTypeGuess> guesses(list.columnTypes.size());
+        string scratch;
+        const char *q = p;
+        for (size_t rows = 0; q < end && rows < TYPE_SAMPLE_ROWS; ++rows) {
+            q = parseCSVRecord(q, end, fields);
+            for (size_t i = 5; i < fields.size() && i - 5 < guesses.size(); ++i) {
+                assignCSVField(scratch, fields[i]);
+                guesses[i - 5].add(scratch);
+            }
+        }
+        for (size_t i = 0; i < guesses.size(); ++i) list.columnTypes[i] = guesses[i].result();
+    }
+
+    if (threads == 0) threads = max(1u, thread::hardware_concurrency());
+    size_t dataSize = end - p;
+    if (dataSize < PARALLEL_LOAD_MIN_BYTES) threads = 1;
+    threads = (unsigned)min<size_t>(threads, max<size_t>(1, dataSize / (PARALLEL_LOAD_MIN_BYTES / 4)));
+
+    vector<CSVChunk> chunks(threads);
+    vector<const char *> rangeStart(threads + 1);
+    for (unsigned i = 0; i <= threads; ++i)
+        rangeStart[i] = p + dataSize * i / threads;
+
+    // Pass 1: quote parity and row estimate per range
+    vector<unsigned char> quoteParity(threads, 0);
+    vector<size_t> lineCount(threads, 0);
+    auto countRange = [&](unsigned i) {
+        size_t quotes = 0, lines = 0;
+        scanKernels.count(rangeStart[i], rangeStart[i + 1], quotes, lines);
+        quoteParity[i] = quotes & 1;
+        lineCount[i] = lines;
+    };
+
+    // Pass 2: find the first record boundary at or after each range start
+    // and parse the records in between.
+    vector<unsigned char> inQuotesAt(threads + 1, 0);
+    auto findBoundary = [&](unsigned i) -> const char * {
+        if (i == 0) return p;
+        if (i == threads) return end;
+        bool inQuotes = inQuotesAt[i];
+        for (const char *q = rangeStart[i]; ; ++q) {
+            q = scanKernels.findAny(q, end, '"', '\n', '\n');
+            if (q == end) return end;
+            if (*q == '"') inQuotes = !inQuotes;
+            else if (!inQuotes) return q + 1;
+        }
+    };
+    auto parseRange = [&](unsigned i) {
+        chunks[i].begin = findBoundary(i);
+        chunks[i].end = max(chunks[i].begin, findBoundary(i + 1));
+        parseCSVChunk(chunks[i], list.columnTypes, lineCount[i] + 1);
+    };
+
+    runOnThreads(threads, countRange);
+    for (unsigned i = 0; i < threads; ++i)
+        inQuotesAt[i + 1] = inQuotesAt[i] ^ quoteParity[i];
+    runOnThreads(threads, parseRange);
+
+    // Merge in file order
+    size_t total = 0;
+    int maxId = 0;
+    for (auto &chunk : chunks) {
+        total += chunk.tasks.size();
+        maxId = max(maxId, chunk.maxId);
+    }
+    stats = CSVLoadStats();
+    list.tasks.clear();
+    list.priorities = prioritySymbols();
+    list.statuses = statusSymbols();
+    for (auto &chunk : chunks) {
+        // Re-code the chunk's rows into the list's symbol tables; nothing
+        // to do when the chunk only saw values the list already has.
+        vector<uint32_t> priorityMap(chunk.priorities.size()), statusMap(chunk.statuses.size());
+        bool identity = true;
+        for (uint32_t c = 0; c < priorityMap.size(); ++c) {
+            priorityMap[c] = list.priorities.intern(chunk.priorities.text(c));
+            identity = identity && priorityMap[c] == c;
+        }
+        for (uint32_t c = 0; c < statusMap.size(); ++c) {
+            statusMap[c] = list.statuses.intern(chunk.statuses.text(c));
+            identity = identity && statusMap[c] == c;
+        }
+        if (identity) continue;
+        for (auto &t : chunk.tasks) {
+            t.priority = priorityMap[t.priority];
+            t.status = statusMap[t.status];
+        }
+    }
+    if (threads == 1) {
+        list.tasks.swap(chunks[0].tasks);
+    } else {
+        list.tasks.reserve(total);
+        for (auto &chunk : chunks) {
+            move(chunk.tasks.begin(), chunk.tasks.end(), back_inserter(list.tasks));
+            vector<Task>().swap(chunk.tasks);
+        }
+    }
+    for (auto &chunk : chunks) {
+        for (auto &row : chunk.malformedRows) stats.malformedRows.push_back(move(row));
+        stats.skipped += chunk.skipped;
+    }
+    list.nextId = maxId + 1;
+    rebuildIndexes(list);
+    markChanged(list);
+
+    stats.rows = list.tasks.size();
+    stats.bytes = file.size;
+    timer.rows = stats.rows;
+    timer.bytesIn = file.size;
+    stats.threads = threads;
+    stats.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return true;
+}
+
+
+// ---------- Binary snapshots ----------
+// A .tbs file is the whole board laid out the way it sits in memory:
+// fixed-width arrays for ids, priority/status codes, deadlines and typed
+// cells, and string heaps for text. Opening one maps the file and copies
+// the arrays into tasks — nothing is parsed, so a million rows open in
+// milliseconds. CSV stays the format for sharing and hand edits.
+//
+//   header | section | section | ... | directory
+//
+// Every section starts 8-byte aligned; the directory at the end says what
+// each one holds and where. A string section is a uint64 count, count + 1
+// uint64 offsets into the characters that follow, then the characters.
+
+const char SNAPSHOT_MAGIC[8] = {'T', 'A', 'S', 'K', 'S', 'N', 'A', 'P'};
+const uint32_t SNAPSHOT_VERSION = 1;
+const uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304;   // reads back swapped on the other endianness
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint64_t rows;
+    uint32_t extraColumns;
+    int32_t nextId;
+    uint32_t sectionCount;
+    uint32_t journalSegment;   // first journal segment not folded in (see Journal)
+    uint64_t directoryOffset;
+};
+
+enum SnapshotSectionKind : uint32_t {
+    SEC_COLUMN_NAMES = 1, SEC_COLUMN_TYPES, SEC_PRIORITY_SYMBOLS, SEC_STATUS_SYMBOLS,
+    SEC_IDS, SEC_PRIORITIES, SEC_STATUSES, SEC_DEADLINE_MINUTES, SEC_NAMES, SEC_DEADLINES,
+    SEC_DUE_ORDER,   // rows in deadline-index order, so loading skips the sort
+    // One of each per custom column
+    SEC_CELL_KINDS, SEC_CELL_VALUES, SEC_CELL_TEXT
+};
+
+struct SnapshotSection {
+    uint32_t kind;
+    uint32_t column;
+    uint64_t offset;
+    uint64_t bytes;
+};
+
+struct SnapshotWriter {
+    ostream &out;
+    uint64_t pos = 0;
+    vector<SnapshotSection> sections;
+
+    SnapshotWriter(ostream &o) : out(o) {}
+    void write(const void *p, size_t n) {
+        out.write((const char *)p, n);
+        pos += n;
+    }
+    void align() {
+        static const char zeros[8] = {};
+        if (pos % 8) write(zeros, 8 - pos % 8);
+    }
+    template <class T>
+    void array(uint32_t kind, uint32_t column, const vector<T> &values) {
+        align();
+        sections.push_back({kind, column, pos, values.size() * sizeof(T)});
+        write(values.data(), values.size() * sizeof(T));
+    }
+    // text(i) returns the i-th string; it's called twice per string.
+    template <class F>
+    void strings(uint32_t kind, uint32_t column, size_t count, F &&text) {
+        align();
+        uint64_t start = pos, n = count;
+        vector<uint64_t> offsets(count + 1, 0);
+        for (size_t i = 0; i < count; ++i) offsets[i + 1] = offsets[i] + text(i).size();
+        write(&n, sizeof(n));
+        write(offsets.data(), offsets.size() * sizeof(uint64_t));
+        for (size_t i = 0; i < count; ++i) {
+            string_view s = text(i);
+            write(s.data(), s.size());
+        }
+        sections.push_back({kind, column, start, pos - start});
+    }
+};
+
+bool writeSnapshotTo(const ToDoList &list, ostream &out, uint32_t journalSegment) {
+    SnapshotWriter w(out);
+    streampos start = out.tellp();
+    size_t rows = list.tasks.size(), columns = list.columnNames.size();
+    SnapshotHeader header = {};
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.byteOrder = SNAPSHOT_BYTE_ORDER;
+    header.rows = rows;
+    header.extraColumns = (uint32_t)columns;
+    header.nextId = list.nextId;
+    header.journalSegment = journalSegment;
+    w.write(&header, sizeof(header));   // rewritten once the directory is known
+
+    w.strings(SEC_COLUMN_NAMES, 0, columns, [&](size_t c) { return string_view(list.columnNames[c]); });
+    vector<uint8_t> types(list.columnTypes.begin(), list.columnTypes.end());
+    w.array(SEC_COLUMN_TYPES, 0, types);
+    // Symbols in code order, so interning them again hands out the same codes
+    w.strings(SEC_PRIORITY_SYMBOLS, 0, list.priorities.size(),
+              [&](size_t c) { return string_view(list.priorities.text((uint32_t)c)); });
+    w.strings(SEC_STATUS_SYMBOLS, 0, list.statuses.size(),
+              [&](size_t c) { return string_view(list.statuses.text((uint32_t)c)); });
+
+    vector<int32_t> ids(rows);
+    vector<uint32_t> priorities(rows), statuses(rows);
+    vector<int64_t> minutes(rows);
+    for (size_t r = 0; r < rows; ++r) {
+        const Task &t = list.tasks[r];
+        ids[r] = t.id;
+        priorities[r] = t.priority;
+        statuses[r] = t.status;
+        minutes[r] = t.deadlineMinutes;
+    }
+    w.array(SEC_IDS, 0, ids);
+    w.array(SEC_PRIORITIES, 0, priorities);
+    w.array(SEC_STATUSES, 0, statuses);
+    w.array(SEC_DEADLINE_MINUTES, 0, minutes);
+    w.strings(SEC_NAMES, 0, rows, [&](size_t r) { return string_view(list.tasks[r].name); });
+    w.strings(SEC_DEADLINES, 0, rows, [&](size_t r) { return string_view(list.tasks[r].deadline); });
+    vector<uint32_t> dueOrder;
+    dueOrder.reserve(list.dueIndex.byDeadline.size());
+    for (const auto &d : list.dueIndex.byDeadline) dueOrder.push_back((uint32_t)findRow(list, d.second));
+    w.array(SEC_DUE_ORDER, 0, dueOrder);
+
+    vector<uint8_t> kinds(rows);
+    vector<int64_t> values(rows);
+    for (uint32_t c = 0; c < columns; ++c) {
+        for (size_t r = 0; r < rows; ++r) {
+            const auto &cells = list.tasks[r].extraColumns;
+            kinds[r] = CELL_KIND_MISSING;
+            values[r] = 0;
+            if (c >= cells.size()) continue;
+            kinds[r] = encodeCell(cells[c], values[r]);
+        }
+        w.array(SEC_CELL_KINDS, c, kinds);
+        w.array(SEC_CELL_VALUES, c, values);
+        w.strings(SEC_CELL_TEXT, c, rows, [&](size_t r) {
+            const auto &cells = list.tasks[r].extraColumns;
+            return c < cells.size() ? cells[c].getText() : string_view();
+        });
+    }
+
+    w.align();
+    header.sectionCount = (uint32_t)w.sections.size();
+    header.directoryOffset = w.pos;
+    w.write(w.sections.data(), w.sections.size() * sizeof(SnapshotSection));
+    out.seekp(start);
+    out.write((const char *)&header, sizeof(header));
+    out.seekp(0, ios::end);
+    return (bool)out;
+}
+
+bool writeSnapshot(const ToDoList &list, const string &path, uint32_t journalSegment) {
+    MetricTimer timer(METRIC_SNAPSHOT_WRITE);
+    timer.rows = list.tasks.size();
+    string tmp = path + ".tmp";
+    ofstream out(tmp, ios::binary | ios::trunc);
+    if (!out) return false;
+    bool ok = writeSnapshotTo(list, out, journalSegment);
+    timer.bytesOut = (uint64_t)max<streamoff>(0, out.tellp());
+    out.close();
+    if (!ok || !out) {
+        remove(tmp.c_str());
+        return false;
+    }
+    // Replace the old file only once the new one is complete
+#ifdef _WIN32
+    remove(path.c_str());
+#endif
+    return rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+// A string section, checked and read in place from the mapped file.
+struct SnapshotStrings {
+    size_t count = 0;
+    const uint64_t *offsets = nullptr;
+    const char *chars = nullptr;
+
+    string_view at(size_t i) const { return string_view(chars + offsets[i], offsets[i + 1] - offsets[i]); }
+};
+
+struct SnapshotReader {
+    const char *base = nullptr;
+    size_t size = 0;
+    const SnapshotSection *sections = nullptr;
+    size_t sectionCount = 0;
+    string error;
+
+    const SnapshotSection *find(uint32_t kind, uint32_t column) {
+        for (size_t i = 0; i < sectionCount; ++i)
+            if (sections[i].kind == kind && sections[i].column == column) {
+                const SnapshotSection &s = sections[i];
+                if (s.offset % 8 != 0 || s.offset > size || s.bytes > size - s.offset) break;
+                return &s;
+            }
+        error = "missing or damaged section " + to_string(kind) + "/" + to_string(column);
+        return nullptr;
+    }
+    template <class T>
+    bool array(uint32_t kind, uint32_t column, size_t count, const T *&out) {
+        const SnapshotSection *s = find(kind, column);
+        if (s == nullptr) return false;
+        if (s->bytes != count * sizeof(T)) {
+            error = "wrong size for section " + to_string(kind) + "/" + to_string(column);
+            return false;
+        }
+        out = (const T *)(base + s->offset);
+        return true;
+    }
+    bool strings(uint32_t kind, uint32_t column, SnapshotStrings &out) {
+        const SnapshotSection *s = find(kind, column);
+        if (s == nullptr) return false;
+        const char *p = base + s->offset;
+        uint64_t count;
+        // The count and at least the first offset must fit
+        if (s->bytes < 2 * sizeof(uint64_t)) return damaged(kind, column);
+        memcpy(&count, p, sizeof(count));
+        if (count >= (s->bytes - sizeof(count)) / sizeof(uint64_t)) return damaged(kind, column);
+        out.count = (size_t)count;
+        out.offsets = (const uint64_t *)(p + sizeof(count));
+        out.chars = (const char *)(out.offsets + count + 1);
+        uint64_t charBytes = s->bytes - sizeof(count) - (count + 1) * sizeof(uint64_t);
+        if (out.offsets[0] != 0 || out.offsets[count] > charBytes) return damaged(kind, column);
+        for (size_t i = 0; i < count; ++i)
+            if (out.offsets[i] > out.offsets[i + 1]) return damaged(kind, column);
+        return true;
+    }
+    bool damaged(uint32_t kind, uint32_t column) {
+        error = "damaged strings in section " + to_string(kind) + "/" + to_string(column);
+        return false;
+    }
+};
+
+bool readSnapshotData(ToDoList &list, const char *data, size_t size, string &error,
+                      uint32_t *journalSegment) {
+    SnapshotHeader header;
+    if (size < sizeof(header)) {
+        error = "not a snapshot";
+        return false;
+    }
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0) {
+        error = "not a snapshot";
+        return false;
+    }
+    if (header.byteOrder != SNAPSHOT_BYTE_ORDER) {
+        error = "written on a machine with a different byte order";
+        return false;
+    }
+    if (header.version != SNAPSHOT_VERSION) {
+        error = "unsupported snapshot version " + to_string(header.version);
+        return false;
+    }
+    if (header.directoryOffset % 8 != 0 || header.directoryOffset > size ||
+        header.sectionCount > (size - header.directoryOffset) / sizeof(SnapshotSection)) {
+        error = "damaged section directory";
+        return false;
+    }
+    // Every row and column takes at least a few bytes of the file
+    if (header.rows > size / sizeof(int32_t) || header.extraColumns > size / sizeof(uint8_t)) {
+        error = "damaged header";
+        return false;
+    }
+
+    SnapshotReader in;
+    in.base = data;
+    in.size = size;
+    in.sections = (const SnapshotSection *)(data + header.directoryOffset);
+    in.sectionCount = header.sectionCount;
+    size_t rows = (size_t)header.rows, columns = header.extraColumns;
+
+    SnapshotStrings columnNames, priorityList, statusList, names, deadlines;
+    const uint8_t *types;
+    const int32_t *ids;
+    const uint32_t *priorities, *statuses;
+    const int64_t *minutes;
+    bool ok = in.strings(SEC_COLUMN_NAMES, 0, columnNames) && columnNames.count == columns &&
+              in.array(SEC_COLUMN_TYPES, 0, columns, types) &&
+              in.strings(SEC_PRIORITY_SYMBOLS, 0, priorityList) &&
+              in.strings(SEC_STATUS_SYMBOLS, 0, statusList) &&
+              in.array(SEC_IDS, 0, rows, ids) &&
+              in.array(SEC_PRIORITIES, 0, rows, priorities) &&
+              in.array(SEC_STATUSES, 0, rows, statuses) &&
+              in.array(SEC_DEADLINE_MINUTES, 0, rows, minutes) &&
+              in.strings(SEC_NAMES, 0, names) && names.count == rows &&
+              in.strings(SEC_DEADLINES, 0, deadlines) && deadlines.count == rows;
+    vector<const uint8_t *> kinds(columns);
+    vector<const int64_t *> values(columns);
+    vector<SnapshotStrings> texts(columns);
+    for (uint32_t c = 0; ok && c < columns; ++c)
+        ok = types[c] <= DT_LINK &&
+             in.array(SEC_CELL_KINDS, c, rows, kinds[c]) &&
+             in.array(SEC_CELL_VALUES, c, rows, values[c]) &&
+             in.strings(SEC_CELL_TEXT, c, texts[c]) && texts[c].count == rows;
+    if (!ok) {
+        error = in.error.empty() ? "damaged header" : in.error;
+        return false;
+    }
+
+    list.columnNames.clear();
+    list.columnTypes.clear();
+    for (size_t c = 0; c < columns; ++c) {
+        list.columnNames.emplace_back(columnNames.at(c));
+        list.columnTypes.push_back((DataType)types[c]);
+    }
+    // The symbol lists start with the built-in values, so the usual
+    // constants (STATUS_COMPLETED, ...) keep meaning the same thing.
+    list.priorities = prioritySymbols();
+    list.statuses = statusSymbols();
+    for (size_t c = 0; c < priorityList.count; ++c)
+        ok = ok && list.priorities.intern(priorityList.at(c)) == c;
+    for (size_t c = 0; c < statusList.count; ++c)
+        ok = ok && list.statuses.intern(statusList.at(c)) == c;
+    if (!ok || list.priorities.size() != priorityList.count || list.statuses.size() != statusList.count) {
+        error = "damaged priority/status symbols";
+        return false;
+    }
+
+    list.tasks.clear();
+    list.tasks.resize(rows);
+    unsigned threads = rows >= PARALLEL_INDEX_MIN_ROWS ? max(1u, thread::hardware_concurrency()) : 1;
+    atomic<bool> bad(false);
+    runOnThreads(threads, [&](unsigned part) {
+        size_t begin = rows * part / threads, end = rows * (part + 1) / threads;
+        for (size_t r = begin; r < end; ++r) {
+            Task &t = list.tasks[r];
+            t.id = ids[r];
+            t.priority = priorities[r];
+            t.status = statuses[r];
+            t.deadlineMinutes = minutes[r];
+            t.name = names.at(r);
+            t.deadline = deadlines.at(r);
+            if (t.priority >= priorityList.count || t.status >= statusList.count) bad = true;
+            t.extraColumns.reserve(columns);
+            for (size_t c = 0; c < columns; ++c) {
+                uint8_t kind = kinds[c][r];
+                if (kind == CELL_KIND_MISSING) break;
+                t.extraColumns.emplace_back();
+                if (!decodeCell(kind, values[c][r], texts[c].at(r), t.extraColumns.back())) bad = true;
+            }
+        }
+    });
+    if (bad) {
+        error = "damaged task rows";
+        return false;
+    }
+    list.nextId = header.nextId;
+
+    // Reuse the saved deadline order if it covers exactly the rows that
+    // belong in the index, in strictly increasing (deadline, id) order;
+    // anything else (say, duplicate ids) falls back to sorting.
+    vector<pair<long long, int>> due;
+    bool dueOk = false;
+    const SnapshotSection *order = in.find(SEC_DUE_ORDER, 0);
+    if (order != nullptr && order->bytes % sizeof(uint32_t) == 0) {
+        const uint32_t *dueRows = (const uint32_t *)(data + order->offset);
+        size_t count = order->bytes / sizeof(uint32_t), dated = 0;
+        for (const auto &t : list.tasks)
+            dated += t.status != STATUS_COMPLETED && t.deadlineMinutes != NO_DEADLINE;
+        dueOk = count == dated;
+        due.reserve(dueOk ? count : 0);
+        for (size_t i = 0; dueOk && i < count; ++i) {
+            dueOk = dueRows[i] < rows;
+            if (!dueOk) break;
+            const Task &t = list.tasks[dueRows[i]];
+            pair<long long, int> d(t.deadlineMinutes, t.id);
+            dueOk = t.status != STATUS_COMPLETED && t.deadlineMinutes != NO_DEADLINE &&
+                    (due.empty() || due.back() < d);
+            due.push_back(d);
+        }
+    }
+    rebuildIndexes(list, dueOk ? &due : nullptr);
+    markChanged(list);
+    if (journalSegment != nullptr) *journalSegment = header.journalSegment;
+    return true;
+}
+
+bool readSnapshot(ToDoList &list, const string &path, string &error, uint32_t *journalSegment) {
+    MappedFile file;
+    if (!file.open(path)) {
+        error = "file not found";
+        return false;
+    }
+    MetricTimer timer(METRIC_SNAPSHOT_READ);
+    timer.bytesIn = file.size;
+    bool ok = readSnapshotData(list, file.data, file.size, error, journalSegment);
+    timer.rows = list.tasks.size();
+    return ok;
+}
+
+
+// ---------- Journal files ----------
+
+string journalSegmentPath(const string &base, uint32_t segment) {
+    return base + ".tbj." + to_string(segment);
+}
+
+int openJournalFile(const string &path) {
+#ifdef _WIN32
+    return _open(path.c_str(), _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+    return ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+#endif
+}
+
+bool writeJournalFile(int fd, const char *p, size_t n) {
+    while (n > 0) {
+#ifdef _WIN32
+        int done = _write(fd, p, (unsigned)min<size_t>(n, 1u << 30));
+#else
+        ssize_t done = ::write(fd, p, n);
+#endif
+        if (done <= 0) return false;
+        p += done;
+        n -= (size_t)done;
+    }
+    return true;
+}
+
+bool syncJournalFile(int fd) {
+#ifdef _WIN32
+    return _commit(fd) == 0;
+#else
+    return fsync(fd) == 0;
+#endif
+}
+
+bool truncateJournalFile(int fd, uint64_t bytes) {
+#ifdef _WIN32
+    return _chsize_s(fd, (__int64)bytes) == 0;
+#else
+    return ftruncate(fd, (off_t)bytes) == 0;
+#endif
+}
+
+void closeJournalFile(int fd) {
+#ifdef _WIN32
+    _close(fd);
+#else
+    ::close(fd);
+#endif
+}
+
+bool fileExists(const string &path) {
+    return ifstream(path).good();
+}
+
+// Reads back what JournalRecord wrote; any overrun clears ok.
+struct JournalReader {
+    const char *p, *end;
+    bool ok = true;
+
+    JournalReader(const char *begin, size_t n) : p(begin), end(begin + n) {}
+    bool take(void *out, size_t n) {
+        if (!ok || (size_t)(end - p) < n) return ok = false;
+        memcpy(out, p, n);
+        p += n;
+        return true;
+    }
+    uint8_t u8() { uint8_t v = 0; take(&v, sizeof(v)); return v; }
+    uint32_t u32() { uint32_t v = 0; take(&v, sizeof(v)); return v; }
+    uint64_t u64() { uint64_t v = 0; take(&v, sizeof(v)); return v; }
+    string_view text() {
+        uint32_t n = u32();
+        if (!ok || (size_t)(end - p) < n) {
+            ok = false;
+            return string_view();
+        }
+        string_view s(p, n);
+        p += n;
+        return s;
+    }
+    // False for a missing cell
+    bool cell(Cell &c) {
+        uint8_t kind = u8();
+        if (!ok || kind == CELL_KIND_MISSING) return false;
+        string_view s;
+        int64_t value = 0;
+        if (cellKindHasText(kind)) s = text();
+        else value = (int64_t)u64();
+        if (ok && !decodeCell(kind, value, s, c)) ok = false;
+        return ok;
+    }
+    void task(ToDoList &list, Task &t) {
+        t.id = (int)u32();
+        t.name = text();
+        t.priority = list.priorities.intern(text());
+        t.deadline = text();
+        t.deadlineMinutes = (long long)u64();
+        t.status = list.statuses.intern(text());
+        uint32_t cells = u32();
+        if (!ok || cells > (size_t)(end - p)) {
+            ok = false;
+            return;
+        }
+        t.extraColumns.resize(cells);
+        for (auto &c : t.extraColumns) ok = cell(c) && ok;
+    }
+};
+
+// Applies one record's bytes to `list`, leaving the indexes to the caller.
+// False, with `list` possibly half changed, if the record doesn't fit it.
+bool applyJournalRecord(ToDoList &list, const char *bytes, size_t n) {
+    JournalReader in(bytes, n);
+    size_t rows = list.tasks.size();
+    switch (in.u8()) {
+        case JR_PUT_TASK: {
+            uint64_t row = in.u64();
+            if (row > rows) return false;
+            Task t;
+            in.task(list, t);
+            if (row == rows) list.tasks.push_back(move(t));
+            else list.tasks[row] = move(t);
+            break;
+        }
+        case JR_REMOVE_ROWS: {
+            uint64_t count = in.u64();
+            if (count > rows) return false;
+            vector<size_t> removed(count);
+            for (size_t i = 0; i < count; ++i) {
+                removed[i] = (size_t)in.u64();
+                if (!in.ok || removed[i] >= rows || (i > 0 && removed[i] <= removed[i - 1])) return false;
+            }
+            size_t kept = 0, next = 0;
+            for (size_t r = 0; r < rows; ++r) {
+                if (next < count && removed[next] == r) {
+                    ++next;
+                    continue;
+                }
+                if (kept != r) list.tasks[kept] = move(list.tasks[r]);
+                ++kept;
+            }
+            list.tasks.erase(list.tasks.begin() + kept, list.tasks.end());
+            break;
+        }
+        case JR_INSERT_ROWS: {
+            uint64_t count = in.u64();
+            if (count > n) return false;
+            vector<Task> merged;
+            merged.reserve(rows + count);
+            size_t src = 0;
+            for (uint64_t i = 0; i < count && in.ok; ++i) {
+                uint64_t row = in.u64();
+                while (merged.size() < row && src < rows) merged.push_back(move(list.tasks[src++]));
+                if (merged.size() != row) return false;
+                merged.emplace_back();
+                in.task(list, merged.back());
+            }
+            while (src < rows) merged.push_back(move(list.tasks[src++]));
+            list.tasks.swap(merged);
+            break;
+        }
+        case JR_INSERT_COLUMN: {
+            uint64_t column = in.u64();
+            string name(in.text());
+            uint8_t type = in.u8();
+            if (column > list.columnNames.size() || type > DT_LINK || in.u64() != rows) return false;
+            list.columnNames.insert(list.columnNames.begin() + column, name);
+            list.columnTypes.insert(list.columnTypes.begin() + column, (DataType)type);
+            for (auto &t : list.tasks) {
+                Cell c;
+                if (!in.cell(c)) continue;
+                auto &cells = t.extraColumns;
+                cells.insert(cells.begin() + min<size_t>(column, cells.size()), move(c));
+            }
+            break;
+        }
+        case JR_DELETE_COLUMN: {
+            uint64_t column = in.u64();
+            if (column >= list.columnNames.size()) return false;
+            list.columnNames.erase(list.columnNames.begin() + column);
+            list.columnTypes.erase(list.columnTypes.begin() + column);
+            for (auto &t : list.tasks)
+                if (column < t.extraColumns.size()) t.extraColumns.erase(t.extraColumns.begin() + column);
+            break;
+        }
+        case JR_DROP_LAST_COLUMN:
+            if (list.columnNames.empty()) return false;
+            list.columnNames.pop_back();
+            list.columnTypes.pop_back();
+            for (auto &t : list.tasks)
+                if (!t.extraColumns.empty()) t.extraColumns.pop_back();
+            break;
+        case JR_REORDER: {
+            if (in.u64() != rows) return false;
+            vector<size_t> order(rows);
+            vector<uint8_t> seen(rows, 0);
+            for (auto &r : order) {
+                r = (size_t)in.u64();
+                if (!in.ok || r >= rows || seen[r]) return false;
+                seen[r] = 1;
+            }
+            vector<Task> sorted;
+            sorted.reserve(rows);
+            for (size_t r : order) sorted.push_back(move(list.tasks[r]));
+            list.tasks.swap(sorted);
+            break;
+        }
+        case JR_REPLACE: {
+            ToDoList fresh;
+            fresh.name = list.name;
+            uint32_t columns = in.u32();
+            if (columns > n) return false;
+            for (uint32_t c = 0; c < columns && in.ok; ++c) {
+                fresh.columnNames.emplace_back(in.text());
+                uint8_t type = in.u8();
+                if (type > DT_LINK) return false;
+                fresh.columnTypes.push_back((DataType)type);
+            }
+            uint64_t count = in.u64();
+            if (count > n) return false;
+            fresh.tasks.resize(count);
+            for (auto &t : fresh.tasks) in.task(fresh, t);
+            list = move(fresh);
+            break;
+        }
+        default:
+            return false;
+    }
+    list.nextId = (int)in.u32();
+    return in.ok && in.p == in.end;
+}
+
+// Replays a segment's records onto `list`. `good` is how many bytes were
+// whole, checksummed records that applied; the rest (a record torn by a
+// crash, usually) is what the caller should cut off.
+bool replayJournalSegment(ToDoList &list, const string &path, uint64_t &good, size_t &records) {
+    good = 0;
+    MappedFile file;
+    if (!file.open(path)) return false;
+    const char *p = file.data;
+    size_t left = file.size;
+    while (left >= 8) {
+        uint32_t header[2];
+        memcpy(header, p, sizeof(header));
+        if (header[0] > left - 8 || journalChecksum(p + 8, header[0]) != header[1]) break;
+        if (!applyJournalRecord(list, p + 8, header[0])) break;
+        p += 8 + header[0];
+        left -= 8 + header[0];
+        good += 8 + header[0];
+        ++records;
+    }
+    return left == 0;
+}
+
+// Folds segments firstSegment..last into a new base.tbs, then deletes them.
+// Runs on its own thread against a private copy of the board, rebuilt from
+// the old snapshot and the segments, so editing carries on meanwhile.
+void compactJournal(Journal &journal, uint32_t last) {
+    uint32_t first;
+    {
+        lock_guard<mutex> guard(journal.lock);
+        first = journal.firstSegment;
+    }
+    ToDoList board;
+    string error, snapshot = journal.base + ".tbs";
+    bool ok = !fileExists(snapshot) || readSnapshot(board, snapshot, error);
+    size_t records = 0;
+    for (uint32_t seg = first; ok && seg <= last; ++seg) {
+        uint64_t good;
+        ok = replayJournalSegment(board, journalSegmentPath(journal.base, seg), good, records);
+    }
+    if (ok) {
+        rebuildIndexes(board);
+        ok = writeSnapshot(board, snapshot, last + 1);
+    }
+    if (ok)
+        for (uint32_t seg = first; seg <= last; ++seg) remove(journalSegmentPath(journal.base, seg).c_str());
+    else if (journal.warn)
+        journal.warn("Journal compaction failed; the journal keeps growing until the next try.");
+
+    lock_guard<mutex> guard(journal.lock);
+    if (ok) journal.firstSegment = last + 1;
+    journal.compacting = false;
+}
+
+// Starts a new segment and compacts the full one. Call holding journal.lock.
+void rotateJournal(Journal &journal) {
+    int fd = openJournalFile(journalSegmentPath(journal.base, journal.segment + 1));
+    if (fd < 0) return;   // keep appending to this one
+    closeJournalFile(journal.fd);
+    journal.fd = fd;
+    journal.segmentBytes = 0;
+    ++journal.segment;
+    if (journal.compactor.joinable()) journal.compactor.join();   // finished, compacting was false
+    journal.compacting = true;
+    journal.compactor = thread(compactJournal, ref(journal), journal.segment - 1);
+}
+
+// Group commit: whatever was appended while the last batch was being
+// written goes out as the next batch, with one write and one fsync.
+void journalLoop(Journal &journal) {
+    unique_lock<mutex> held(journal.lock);
+    while (true) {
+        journal.wake.wait(held, [&journal] { return journal.stop || !journal.pending.empty(); });
+        if (journal.pending.empty()) break;   // stopping, nothing left to write
+        string batch;
+        batch.swap(journal.pending);
+        uint64_t upTo = journal.appended;
+        held.unlock();
+        bool ok;
+        {
+            MetricTimer timer(METRIC_JOURNAL_FLUSH);
+            timer.bytesOut = batch.size();
+            ok = writeJournalFile(journal.fd, batch.data(), batch.size()) && syncJournalFile(journal.fd);
+        }
+        held.lock();
+        journal.failed = journal.failed || !ok;
+        journal.durable = upTo;
+        journal.segmentBytes += batch.size();
+        journal.flushed.notify_all();
+        if (journal.segmentBytes >= COMPACT_JOURNAL_BYTES && !journal.compacting) rotateJournal(journal);
+    }
+}
+
+bool syncJournal(Journal &journal) {
+    unique_lock<mutex> held(journal.lock);
+    uint64_t upTo = journal.appended;
+    journal.flushed.wait(held, [&journal, upTo] { return journal.durable >= upTo || journal.failed; });
+    return !journal.failed;
+}
+
+bool openJournal(Journal &journal, ToDoList &list, const string &base, string &error) {
+    journal.base = base;
+    ToDoList board;
+    board.name = list.name;
+    string snapshot = base + ".tbs";
+    uint32_t first = 0;
+    if (fileExists(snapshot) && !readSnapshot(board, snapshot, error, &first)) {
+        error = "Could not open " + snapshot + ": " + error;
+        return false;
+    }
+    // Segments a finished compaction didn't get to delete
+    for (uint32_t seg = first; seg-- > 0 && remove(journalSegmentPath(base, seg).c_str()) == 0;) {}
+
+    uint32_t seg = first;
+    uint64_t good = 0;
+    size_t records = 0;
+    bool torn = false;
+    while (fileExists(journalSegmentPath(base, seg))) {
+        torn = !replayJournalSegment(board, journalSegmentPath(base, seg), good, records);
+        if (torn || !fileExists(journalSegmentPath(base, seg + 1))) break;
+        ++seg;
+    }
+    if (torn) {
+        if (journal.warn)
+            journal.warn(journalSegmentPath(base, seg) + " ends in a damaged record; replayed up to byte " +
+                         to_string(good) + " and dropped the rest.");
+        for (uint32_t later = seg + 1; remove(journalSegmentPath(base, later).c_str()) == 0; ++later) {}
+    }
+
+    journal.fd = openJournalFile(journalSegmentPath(base, seg));
+    if (journal.fd < 0 || (torn && !truncateJournalFile(journal.fd, good))) {
+        error = "Could not open " + journalSegmentPath(base, seg) + " for writing.";
+        if (journal.fd >= 0) closeJournalFile(journal.fd);
+        journal.fd = -1;
+        return false;
+    }
+    journal.firstSegment = first;
+    journal.segment = seg;
+    journal.segmentBytes = good;
+    rebuildIndexes(board);
+    markChanged(board);
+    list = move(board);
+    journal.replayed = records;
+    journal.flusher = thread(journalLoop, ref(journal));
+    return true;
+}
+
+void closeJournal(Journal &journal) {
+    if (!journal.flusher.joinable()) return;
+    {
+        lock_guard<mutex> guard(journal.lock);
+        journal.stop = true;
+    }
+    journal.wake.notify_one();
+    journal.flusher.join();
+    if (journal.compactor.joinable()) journal.compactor.join();
+    closeJournalFile(journal.fd);
+    journal.fd = -1;
+}
+
+
+// ---------- Sorting ----------
+// Sorts a permutation of row numbers, never the tasks themselves. Keys
+// are sorted least significant first with stable passes, so "Status, then
+// Deadline, then Priority" comes out right. Integer-like keys (ids, dates,
+// priority rank, status order, INT/FLOAT/BOOL/DATE columns) go through an
+// LSD radix sort; text keys through stable_sort. Big boards split either
+// across threads.
+
+// Reorders the tasks so that new row i is old row order[i].
+
+const size_t PARALLEL_SORT_MIN_ROWS = 1 << 18;
+
+struct KeyedRow {
+    uint64_t key;
+    size_t row;
+};
+
+// Radix keys use the low 63 bits for the value; rows with no value of the
+// column's type get the top bit so they sort last either way.
+const uint64_t RADIX_NO_VALUE = 1ull << 63;
+
+uint64_t floatRadixKey(float f) {
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    return (bits & 0x80000000u) ? ~bits & 0xFFFFFFFFu : bits | 0x80000000u;
+}
+
+// Fills keys[r] for an integer-like column; false for text columns.
+bool buildRadixKeys(const ToDoList &list, const ColumnStore &cols, int column, vector<uint64_t> &keys) {
+    size_t n = cols.rows;
+    keys.resize(n);
+    const long long MINUTES_BIAS = 1ll << 62;   // parseDateTime years stay far inside this
+    auto minutesKey = [&](long long m) { return m == LLONG_MAX ? RADIX_NO_VALUE : (uint64_t)(m + MINUTES_BIAS); };
+    switch (column) {
+        case 0: {
+            const vector<int> &ids = cols.ids();
+            for (size_t r = 0; r < n; ++r) keys[r] = (uint64_t)((long long)ids[r] - INT_MIN);
+            return true;
+        }
+        case 1:
+            return false;
+        case 2: {
+            // High, Medium, Low, then anything else.
+            const vector<uint8_t> &ranks = cols.priorityRanks();
+            for (size_t r = 0; r < n; ++r) keys[r] = 3 - ranks[r];
+            return true;
+        }
+        case 3: {
+            const vector<long long> &minutes = cols.deadlineMinutes();
+            for (size_t r = 0; r < n; ++r) keys[r] = minutesKey(minutes[r]);
+            return true;
+        }
+        case 4: {
+            vector<uint32_t> textOrder = list.statuses.textOrder();
+            const vector<uint32_t> &statuses = cols.statuses();
+            for (size_t r = 0; r < n; ++r) keys[r] = textOrder[statuses[r]];
+            return true;
+        }
+    }
+    const ExtraColumn &col = cols.extra(column - 5);
+    for (size_t r = 0; r < n; ++r) {
+        bool native = col.state[r] == CELL_NATIVE;
+        switch (col.type) {
+            case DT_INT: keys[r] = native ? (uint64_t)((long long)col.ints[r] - INT_MIN) : RADIX_NO_VALUE; break;
+            case DT_FLOAT: keys[r] = native ? floatRadixKey(col.floats[r]) : RADIX_NO_VALUE; break;
+            case DT_BOOL: keys[r] = native ? col.bools[r] : RADIX_NO_VALUE; break;
+            case DT_DATE: keys[r] = native ? minutesKey(col.dates[r]) : RADIX_NO_VALUE; break;
+            default: return false;
+        }
+    }
+    return true;
+}
+
+// Stable LSD radix sort, a byte per pass. Bytes that are the same in every
+// key are skipped, so a 3-value priority key takes a single pass. With
+// several threads each one histograms and scatters its own slice; slices
+// are laid out in thread order within each bucket, which keeps it stable.
+void radixSortRows(vector<KeyedRow> &items, unsigned threads) {
+    size_t n = items.size();
+    uint64_t anyBits = 0, allBits = ~0ull;
+    for (const auto &it : items) {
+        anyBits |= it.key;
+        allBits &= it.key;
+    }
+    uint64_t varying = anyBits ^ allBits;
+    if (varying == 0) return;
+
+    if (n < PARALLEL_SORT_MIN_ROWS) threads = 1;
+    vector<KeyedRow> buffer(n);
+    vector<array<size_t, 256>> counts(threads);
+    auto sliceBegin = [&](unsigned t) { return n * t / threads; };
+
+    for (int shift = 0; shift < 64; shift += 8) {
+        if (((varying >> shift) & 0xFF) == 0) continue;
+        runOnThreads(threads, [&](unsigned t) {
+            auto &count = counts[t];
+            count.fill(0);
+            for (size_t i = sliceBegin(t), end = sliceBegin(t + 1); i < end; ++i)
+                ++count[(items[i].key >> shift) & 0xFF];
+        });
+        size_t sum = 0;
+        for (int d = 0; d < 256; ++d) {
+            for (unsigned t = 0; t < threads; ++t) {
+                size_t c = counts[t][d];
+                counts[t][d] = sum;
+                sum += c;
+            }
+        }
+        runOnThreads(threads, [&](unsigned t) {
+            auto &next = counts[t];
+            for (size_t i = sliceBegin(t), end = sliceBegin(t + 1); i < end; ++i)
+                buffer[next[(items[i].key >> shift) & 0xFF]++] = items[i];
+        });
+        items.swap(buffer);
+    }
+}
+
+// stable_sort, or on big inputs a stable_sort per thread followed by
+// rounds of pairwise inplace_merge (which keeps equal keys in order).
+template <class Less>
+void stableSortRows(vector<size_t> &order, Less less, unsigned threads) {
+    size_t n = order.size();
+    if (threads <= 1 || n < PARALLEL_SORT_MIN_ROWS) {
+        stable_sort(order.begin(), order.end(), less);
+        return;
+    }
+    vector<size_t> bounds(threads + 1);
+    for (unsigned t = 0; t <= threads; ++t) bounds[t] = n * t / threads;
+    runOnThreads(threads, [&](unsigned t) {
+        stable_sort(order.begin() + bounds[t], order.begin() + bounds[t + 1], less);
+    });
+    for (unsigned width = 1; width < threads; width *= 2) {
+        vector<thread> pool;
+        for (unsigned t = 0; t + width < threads; t += 2 * width) {
+            auto lo = order.begin() + bounds[t];
+            auto mid = order.begin() + bounds[t + width];
+            auto hi = order.begin() + bounds[min(t + 2 * width, threads)];
+            pool.emplace_back([lo, mid, hi, &less] { inplace_merge(lo, mid, hi, less); });
+        }
+        for (auto &th : pool) th.join();
+    }
+}
+
+vector<size_t> sortedRowOrder(const ToDoList &list, const vector<SortKey> &keys, unsigned threads) {
+    const ColumnStore &cols = columnsOf(list);
+    if (threads == 0) threads = max(1u, thread::hardware_concurrency());
+    vector<size_t> order(cols.rows);
+    iota(order.begin(), order.end(), 0);
+
+    vector<uint64_t> radixKeys;
+    vector<KeyedRow> items;
+    for (auto k = keys.rbegin(); k != keys.rend(); ++k) {
+        if (buildRadixKeys(list, cols, k->column, radixKeys)) {
+            items.resize(order.size());
+            for (size_t i = 0; i < order.size(); ++i) {
+                uint64_t key = radixKeys[order[i]];
+                if (k->descending && !(key & RADIX_NO_VALUE)) key = (RADIX_NO_VALUE - 1) - key;
+                items[i] = {key, order[i]};
+            }
+            radixSortRows(items, threads);
+            for (size_t i = 0; i < order.size(); ++i) order[i] = items[i].row;
+            continue;
+        }
+
+        // Text: task names, or a STRING/LINK column (missing cells last).
+        const StringColumn &text = k->column == 1 ? cols.names() : cols.extra(k->column - 5).strings;
+        const vector<uint8_t> *state = k->column == 1 ? nullptr : &cols.extra(k->column - 5).state;
+        bool descending = k->descending;
+        stableSortRows(order, [&text, state, descending](size_t a, size_t b) {
+            if (state) {
+                bool missingA = (*state)[a] == CELL_MISSING, missingB = (*state)[b] == CELL_MISSING;
+                if (missingA != missingB) return missingB;
+                if (missingA) return false;
+            }
+            int c = text.at(a).compare(text.at(b));
+            return descending ? c > 0 : c < 0;
+        }, threads);
+    }
+    return order;
+}
+
+bool parseSortKeys(const string &text, size_t columnCount, vector<SortKey> &keys) {
+    keys.clear();
+    stringstream ss(text);
+    string part;
+    while (getline(ss, part, ',')) {
+        size_t b = part.find_first_not_of(" \t"), e = part.find_last_not_of(" \t");
+        if (b == string::npos) return false;
+        string_view item(part.data() + b, e - b + 1);
+        bool descending = !item.empty() && item[0] == '-';
+        if (descending) item.remove_prefix(1);
+        int column;
+        if (!parseIntText(item, column) || column < 0 || (size_t)column >= 5 + columnCount) return false;
+        keys.push_back({column, descending});
+    }
+    return !keys.empty();
+}
+
+void sortRows(ToDoList &list, UndoLog &undo, const vector<SortKey> &keys) {
+    MetricTimer timer(METRIC_SORT);
+    timer.rows = list.tasks.size();
+    vector<size_t> order = sortedRowOrder(list, keys);
+    applyRowOrder(list, order);
+    UndoStep step = makeUndoStep(UNDO_REORDER, list);
+    step.rows = move(order);
+    recordEdit(list, undo, move(step));
+}
+
+bool extraCellMatches(const ToDoList &list, const ExtraColumn &col, size_t idx, size_t r,
+                      const Cell &wanted, long long wantedDate, const string &value) {
+    if (col.state[r] == CELL_MISSING) return false;
+    if (col.state[r] == CELL_TEXT || wanted.type() != col.type)
+        return list.tasks[r].extraColumns[idx].getAsString() == value;
+    switch (col.type) {
+        case DT_INT: return col.ints[r] == wanted.getInt();
+        case DT_FLOAT: return col.floats[r] == wanted.getFloat();
+        case DT_BOOL: return col.bools[r] == wanted.getBool();
+        case DT_DATE: return col.dates[r] == wantedDate;
+        default: return col.strings.at(r) == value;
+    }
+}
+
+
+// ---------- Filter expressions ----------
+
+struct FilterToken {
+    enum Kind { WORD, QUOTED, OP, LPAREN, RPAREN } kind;
+    string_view text;     // without quotes for QUOTED
+    size_t begin, end;    // span in the source, quotes included
+};
+
+bool isFilterSymbol(char c) {
+    return c == '(' || c == ')' || c == '=' || c == '!' || c == '<' || c == '>' || c == '"';
+}
+
+bool tokenizeFilter(string_view src, vector<FilterToken> &tokens, string &error) {
+    size_t i = 0;
+    while (i < src.size()) {
+        char c = src[i];
+        if (isspace((unsigned char)c)) { ++i; continue; }
+        size_t start = i;
+        if (c == '(' || c == ')') {
+            tokens.push_back({c == '(' ? FilterToken::LPAREN : FilterToken::RPAREN, src.substr(i, 1), i, i + 1});
+            ++i;
+        } else if (c == '"') {
+            size_t close = src.find('"', i + 1);
+            if (close == string_view::npos) { error = "missing closing quote"; return false; }
+            tokens.push_back({FilterToken::QUOTED, src.substr(i + 1, close - i - 1), i, close + 1});
+            i = close + 1;
+        } else if (c == '=' || c == '!' || c == '<' || c == '>') {
+            ++i;
+            if (i < src.size() && (src[i] == '=' || (c == '<' && src[i] == '>'))) ++i;
+            tokens.push_back({FilterToken::OP, src.substr(start, i - start), start, i});
+        } else {
+            while (i < src.size() && !isspace((unsigned char)src[i]) && !isFilterSymbol(src[i])) ++i;
+            tokens.push_back({FilterToken::WORD, src.substr(start, i - start), start, i});
+        }
+    }
+    return true;
+}
+
+bool equalsIgnoreCase(string_view a, string_view b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i)
+        if (tolower((unsigned char)a[i]) != tolower((unsigned char)b[i])) return false;
+    return true;
+}
+
+// Recursive descent over the tokens: OR binds loosest, then AND, then NOT.
+struct FilterParser {
+    string_view src;
+    vector<FilterToken> tokens;
+    size_t pos = 0;
+    string error;
+
+    bool atKeyword(const char *word) const {
+        return pos < tokens.size() && tokens[pos].kind == FilterToken::WORD && equalsIgnoreCase(tokens[pos].text, word);
+    }
+    bool fail(const string &message) {
+        if (error.empty()) error = message;
+        return false;
+    }
+
+    bool parseOr(FilterExpr &out) {
+        if (!parseAnd(out)) return false;
+        if (!atKeyword("OR")) return true;
+        FilterExpr group;
+        group.kind = EXPR_OR;
+        group.children.push_back(move(out));
+        while (atKeyword("OR")) {
+            ++pos;
+            group.children.emplace_back();
+            if (!parseAnd(group.children.back())) return false;
+        }
+        out = move(group);
+        return true;
+    }
+    bool parseAnd(FilterExpr &out) {
+        if (!parseNot(out)) return false;
+        if (!atKeyword("AND")) return true;
+        FilterExpr group;
+        group.kind = EXPR_AND;
+        group.children.push_back(move(out));
+        while (atKeyword("AND")) {
+            ++pos;
+            group.children.emplace_back();
+            if (!parseNot(group.children.back())) return false;
+        }
+        out = move(group);
+        return true;
+    }
+    bool parseNot(FilterExpr &out) {
+        if (atKeyword("NOT")) {
+            ++pos;
+            out.kind = EXPR_NOT;
+            out.children.emplace_back();
+            return parseNot(out.children.back());
+        }
+        if (pos < tokens.size() && tokens[pos].kind == FilterToken::LPAREN) {
+            ++pos;
+            if (!parseOr(out)) return false;
+            if (pos >= tokens.size() || tokens[pos].kind != FilterToken::RPAREN) return fail("missing ')'");
+            ++pos;
+            return true;
+        }
+        return parseComparison(out);
+    }
+    // column op value. An unquoted column or value may span several words
+    // ("Due Date", "01/08/2026 00:00"); the value runs up to AND, OR or ')'.
+    bool parseComparison(FilterExpr &out) {
+        out.kind = EXPR_COMPARE;
+        size_t first = pos;
+        if (pos < tokens.size() && tokens[pos].kind == FilterToken::QUOTED) {
+            out.column = string(tokens[pos++].text);
+        } else {
+            while (pos < tokens.size() && tokens[pos].kind == FilterToken::WORD) ++pos;
+            if (pos == first) return fail("expected a column name");
+            out.column = string(src.substr(tokens[first].begin, tokens[pos - 1].end - tokens[first].begin));
+        }
+        if (pos >= tokens.size() || tokens[pos].kind != FilterToken::OP)
+            return fail("expected =, !=, <, <=, > or >= after '" + out.column + "'");
+        string_view op = tokens[pos++].text;
+        if (op == "=" || op == "==") out.op = OP_EQ;
+        else if (op == "!=" || op == "<>") out.op = OP_NE;
+        else if (op == "<") out.op = OP_LT;
+        else if (op == "<=") out.op = OP_LE;
+        else if (op == ">") out.op = OP_GT;
+        else if (op == ">=") out.op = OP_GE;
+        else return fail("unknown operator '" + string(op) + "'");
+
+        if (pos < tokens.size() && tokens[pos].kind == FilterToken::QUOTED) {
+            out.value = string(tokens[pos++].text);
+            return true;
+        }
+        size_t valueStart = pos;
+        while (pos < tokens.size() && tokens[pos].kind == FilterToken::WORD && !atKeyword("AND") && !atKeyword("OR")) ++pos;
+        if (pos == valueStart) return fail("expected a value after '" + out.column + " " + string(op) + "'");
+        out.value = string(src.substr(tokens[valueStart].begin, tokens[pos - 1].end - tokens[valueStart].begin));
+        return true;
+    }
+};
+
+bool parseFilterExpr(string_view src, FilterExpr &out, string &error) {
+    FilterParser parser;
+    parser.src = src;
+    if (!tokenizeFilter(src, parser.tokens, error)) return false;
+    if (parser.tokens.empty()) { error = "empty expression"; return false; }
+    if (!parser.parseOr(out)) { error = parser.error; return false; }
+    if (parser.pos != parser.tokens.size()) {
+        error = "unexpected '" + string(parser.tokens[parser.pos].text) + "'";
+        return false;
+    }
+    return true;
+}
+
+// [lo, hi] for "x op v" over integers; false if no value can match.
+bool integerRange(FilterOp op, long long v, long long minV, long long maxV, long long &lo, long long &hi, bool &negate) {
+    lo = minV; hi = maxV; negate = false;
+    switch (op) {
+        case OP_EQ: lo = hi = v; break;
+        case OP_NE: lo = hi = v; negate = true; break;
+        case OP_LT: if (v <= minV) return false; hi = v - 1; break;
+        case OP_LE: hi = v; break;
+        case OP_GT: if (v >= maxV) return false; lo = v + 1; break;
+        case OP_GE: lo = v; break;
+    }
+    return true;
+}
+
+void floatRange(FilterOp op, float v, float &lo, float &hi, bool &negate) {
+    lo = -numeric_limits<float>::infinity(); hi = numeric_limits<float>::infinity(); negate = false;
+    switch (op) {
+        case OP_EQ: lo = hi = v; break;
+        case OP_NE: lo = hi = v; negate = true; break;
+        case OP_LT: hi = nextafter(v, lo); break;
+        case OP_LE: hi = v; break;
+        case OP_GT: lo = nextafter(v, hi); break;
+        case OP_GE: lo = v; break;
+    }
+}
+
+bool compareMatches(FilterOp op, int c) {
+    switch (op) {
+        case OP_EQ: return c == 0;
+        case OP_NE: return c != 0;
+        case OP_LT: return c < 0;
+        case OP_LE: return c <= 0;
+        case OP_GT: return c > 0;
+        case OP_GE: return c >= 0;
+    }
+    return false;
+}
+
+bool compileIntLeaf(FilterNode &node, const vector<int> &column, FilterOp op, const string &value, const string &name, string &error) {
+    int v;
+    if (!parseIntText(value, v)) { error = "'" + value + "' is not a whole number (column " + name + ")"; return false; }
+    node.kind = integerRange(op, v, INT_MIN, INT_MAX, node.lo, node.hi, node.negate) ? PLAN_INT : PLAN_NONE;
+    node.ints = &column;
+    return true;
+}
+
+bool compileMinutesLeaf(FilterNode &node, const vector<long long> &column, FilterOp op, const string &value, const string &name, string &error) {
+    long long v;
+    if (!parseDateTime(value, v)) { error = "'" + value + "' is not a dd/mm/yyyy hh:mm date (column " + name + ")"; return false; }
+    node.kind = integerRange(op, v, LLONG_MIN, LLONG_MAX - 1, node.lo, node.hi, node.negate) ? PLAN_MINUTES : PLAN_NONE;
+    node.minutes = &column;
+    return true;
+}
+
+void compileTextLeaf(FilterNode &node, const StringColumn &column, FilterOp op, const string &value) {
+    node.kind = PLAN_TEXT;
+    node.strings = &column;
+    node.op = op;
+    node.text = value;
+}
+
+// Symbol code equality (priority or status); a value the list has never
+// seen matches nothing, or everything for !=.
+void compileCodeLeaf(FilterNode &node, const vector<uint32_t> &column, const SymbolTable &symbols, FilterOp op, const string &value) {
+    uint32_t code;
+    if (!symbols.find(value, code)) {
+        node.kind = op == OP_EQ ? PLAN_NONE : PLAN_ALL;
+        return;
+    }
+    node.kind = PLAN_CODE;
+    node.codes = &column;
+    node.lo = node.hi = code;
+    node.negate = op == OP_NE;
+}
+
+// One comparison against a built-in or custom column.
+bool compileComparison(const FilterExpr &e, const ToDoList &list, const ColumnStore &cols, FilterNode &node, string &error) {
+    const string &col = e.column;
+    node.cost = 1;
+    if (equalsIgnoreCase(col, "id")) return compileIntLeaf(node, cols.ids(), e.op, e.value, col, error);
+    if (equalsIgnoreCase(col, "deadline")) return compileMinutesLeaf(node, cols.deadlineMinutes(), e.op, e.value, col, error);
+    if (equalsIgnoreCase(col, "name") || equalsIgnoreCase(col, "taskname")) {
+        compileTextLeaf(node, cols.names(), e.op, e.value);
+        node.cost = 8;
+        return true;
+    }
+    if (equalsIgnoreCase(col, "priority")) {
+        if (e.op == OP_EQ || e.op == OP_NE) {
+            compileCodeLeaf(node, cols.priorities(), list.priorities, e.op, e.value);
+            return true;
+        }
+        // Ordered comparisons use rank (High > Medium > Low), as the scheduler does.
+        uint32_t code;
+        if (!list.priorities.find(e.value, code) || getPriorityValue(code) == 0) {
+            error = "priority can only be ordered against High, Medium or Low";
+            return false;
+        }
+        node.kind = integerRange(e.op, getPriorityValue(code), 0, 255, node.lo, node.hi, node.negate) ? PLAN_BYTE : PLAN_NONE;
+        node.bytes = &cols.priorityRanks();
+        return true;
+    }
+    if (equalsIgnoreCase(col, "status")) {
+        if (e.op != OP_EQ && e.op != OP_NE) { error = "status only supports = and !="; return false; }
+        compileCodeLeaf(node, cols.statuses(), list.statuses, e.op, e.value);
+        return true;
+    }
+
+    int idx = findColumn(list, col);
+    if (idx < 0) {
+        // Custom column names are matched exactly first, then ignoring case.
+        for (size_t i = 0; i < list.columnNames.size() && idx < 0; ++i)
+            if (equalsIgnoreCase(list.columnNames[i], col)) idx = (int)i;
+    }
+    if (idx < 0) { error = "unknown column '" + col + "'"; return false; }
+
+    const ExtraColumn &ec = cols.extra(idx);
+    node.state = &ec.state;
+    switch (ec.type) {
+        case DT_INT: return compileIntLeaf(node, ec.ints, e.op, e.value, col, error);
+        case DT_DATE: return compileMinutesLeaf(node, ec.dates, e.op, e.value, col, error);
+        case DT_FLOAT: {
+            float v;
+            if (!parseFloatText(e.value, v)) { error = "'" + e.value + "' is not a number (column " + col + ")"; return false; }
+            floatRange(e.op, v, node.flo, node.fhi, node.negate);
+            node.kind = PLAN_FLOAT;
+            node.floats = &ec.floats;
+            return true;
+        }
+        case DT_BOOL: {
+            bool v;
+            if (e.op != OP_EQ && e.op != OP_NE) { error = col + " is a yes/no column; use = or !="; return false; }
+            if (!parseBoolText(e.value, v)) { error = "'" + e.value + "' is not yes/no (column " + col + ")"; return false; }
+            node.kind = PLAN_BYTE;
+            node.bytes = &ec.bools;
+            node.lo = node.hi = v;
+            node.negate = e.op == OP_NE;
+            return true;
+        }
+        case DT_STRING:
+        case DT_LINK:
+            compileTextLeaf(node, ec.strings, e.op, e.value);
+            node.cost = 8;
+            return true;
+    }
+    return false;
+}
+
+bool compileFilter(const FilterExpr &e, const ToDoList &list, const ColumnStore &cols, FilterNode &node, string &error) {
+    if (e.kind == EXPR_COMPARE) return compileComparison(e, list, cols, node, error);
+
+    node.kind = e.kind == EXPR_AND ? PLAN_AND : e.kind == EXPR_OR ? PLAN_OR : PLAN_NOT;
+    node.children.resize(e.children.size());
+    node.cost = 0;
+    for (size_t i = 0; i < e.children.size(); ++i) {
+        if (!compileFilter(e.children[i], list, cols, node.children[i], error)) return false;
+        node.cost += node.children[i].cost;
+    }
+    // Cheap typed scans first: the text compares after them only see the
+    // rows that are still undecided.
+    stable_sort(node.children.begin(), node.children.end(),
+                [](const FilterNode &a, const FilterNode &b) { return a.cost < b.cost; });
+    return true;
+}
+
+// out = rows in `cand` where lo <= column[r] <= hi (negated for !=) and
+// valid(r). Works a 64-row word at a time with no branches inside the
+// word, so the compiler can vectorize it; words with no candidates are
+// skipped outright.
+template <class T, class Valid>
+void scanRange(const vector<T> &column, T lo, T hi, bool negate, Valid valid, const RowBitmap &cand, RowBitmap &out) {
+    size_t n = column.size();
+    for (size_t w = 0; w < cand.words.size(); ++w) {
+        uint64_t c = cand.words[w];
+        if (c == 0) { out.words[w] = 0; continue; }
+        size_t base = w * 64, end = min(base + 64, n);
+        uint64_t bits = 0;
+        for (size_t r = base; r < end; ++r) {
+            T x = column[r];
+            bool inRange = (x >= lo) & (x <= hi);
+            bits |= uint64_t((inRange != negate) & valid(r)) << (r - base);
+        }
+        out.words[w] = bits & c;
+    }
+}
+
+template <class T>
+void scanLeaf(const FilterNode &node, const vector<T> &column, T lo, T hi, const RowBitmap &cand, RowBitmap &out) {
+    if (node.state) {
+        const uint8_t *state = node.state->data();
+        scanRange(column, lo, hi, node.negate, [state](size_t r) { return state[r] == CELL_NATIVE; }, cand, out);
+    } else {
+        scanRange(column, lo, hi, node.negate, [](size_t) { return true; }, cand, out);
+    }
+}
+
+void runFilter(FilterNode &node, const RowBitmap &cand, RowBitmap &out) {
+    auto sized = [&cand](RowBitmap &b) {
+        if (b.rows != cand.rows) b = RowBitmap(cand.rows);
+    };
+    switch (node.kind) {
+        case PLAN_ALL: out = cand; break;
+        case PLAN_NONE: out.clearAll(); break;
+        case PLAN_AND:
+            out = cand;
+            for (auto &child : node.children) {
+                if (out.none()) break;
+                sized(child.result);
+                runFilter(child, out, child.result);
+                out.words.swap(child.result.words);
+            }
+            break;
+        case PLAN_OR:
+            out.clearAll();
+            node.rest = cand;   // rows no child has matched yet
+            for (auto &child : node.children) {
+                if (node.rest.none()) break;
+                sized(child.result);
+                runFilter(child, node.rest, child.result);
+                out.orWith(child.result);
+                node.rest.andNotWith(child.result);
+            }
+            break;
+        case PLAN_NOT: {
+            FilterNode &child = node.children[0];
+            sized(child.result);
+            runFilter(child, cand, child.result);
+            out = cand;
+            out.andNotWith(child.result);
+            break;
+        }
+        case PLAN_INT: scanLeaf<int>(node, *node.ints, (int)node.lo, (int)node.hi, cand, out); break;
+        case PLAN_FLOAT: scanLeaf<float>(node, *node.floats, node.flo, node.fhi, cand, out); break;
+        case PLAN_MINUTES: {
+            // LLONG_MAX marks "no date" (NO_DEADLINE, or an unreadable date cell).
+            const long long *m = node.minutes->data();
+            const uint8_t *state = node.state ? node.state->data() : nullptr;
+            if (state)
+                scanRange(*node.minutes, node.lo, node.hi, node.negate,
+                          [m, state](size_t r) { return (m[r] != LLONG_MAX) & (state[r] == CELL_NATIVE); }, cand, out);
+            else
+                scanRange(*node.minutes, node.lo, node.hi, node.negate, [m](size_t r) { return m[r] != LLONG_MAX; }, cand, out);
+            break;
+        }
+        case PLAN_CODE: scanLeaf<uint32_t>(node, *node.codes, (uint32_t)node.lo, (uint32_t)node.hi, cand, out); break;
+        case PLAN_BYTE: scanLeaf<uint8_t>(node, *node.bytes, (uint8_t)node.lo, (uint8_t)node.hi, cand, out); break;
+        case PLAN_TEXT: {
+            out.clearAll();
+            const uint8_t *state = node.state ? node.state->data() : nullptr;
+            cand.forEach([&](size_t r) {
+                if (state && state[r] == CELL_MISSING) return;
+                if (compareMatches(node.op, node.strings->at(r).compare(node.text))) out.set(r);
+            });
+            break;
+        }
+    }
+}
+
+
+// ---------- Text search ----------
+
+// Letters, digits and any byte of a UTF-8 sequence, whatever the locale.
+inline bool isWordByte(unsigned char c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c >= 0x80;
+}
+
+inline char foldByte(char c) { return c >= 'A' && c <= 'Z' ? (char)(c + ('a' - 'A')) : c; }
+
+inline uint32_t trigramKey(const char *p) {
+    return (uint32_t)(uint8_t)p[0] << 16 | (uint32_t)(uint8_t)p[1] << 8 | (uint8_t)p[2];
+}
+
+// Calls f(word) for each word of `text`, lowercased into `word`.
+template <class F>
+void forEachWord(string_view text, string &word, F f) {
+    size_t i = 0;
+    while (i < text.size()) {
+        while (i < text.size() && !isWordByte(text[i])) ++i;
+        word.clear();
+        while (i < text.size() && isWordByte(text[i])) word += foldByte(text[i++]);
+        if (!word.empty()) f(word);
+    }
+}
+
+// Calls f(text) for a task's name, then each of its STRING cells.
+template <class F>
+void forEachTaskText(const ToDoList &list, const Task &t, F f) {
+    f(string_view(t.name));
+    for (size_t c = 0; c < t.extraColumns.size() && c < list.columnTypes.size(); ++c)
+        if (list.columnTypes[c] == DT_STRING) f(t.extraColumns[c].getText());
+}
+
+// Reused between documents so indexing a board doesn't allocate per task.
+struct TextScratch {
+    string word;
+    vector<string> words;
+    vector<uint32_t> trigrams;
+};
+
+void forgetTextDocument(TextIndex &index, int id) {
+    auto it = index.docOfTask.find(id);
+    if (it == index.docOfTask.end()) return;
+    index.docTask[it->second] = -1;
+    ++index.stale;
+    index.docOfTask.erase(it);
+}
+
+void addTextDocument(TextIndex &index, const ToDoList &list, const Task &t, TextScratch &s) {
+    forgetTextDocument(index, t.id);
+    uint32_t doc = (uint32_t)index.docTask.size();
+    index.docTask.push_back(t.id);
+    index.docOfTask[t.id] = doc;
+    s.words.clear();
+    s.trigrams.clear();
+    forEachTaskText(list, t, [&s](string_view text) {
+        forEachWord(text, s.word, [&s](const string &w) {
+            s.words.push_back(w);
+            for (size_t i = 0; i + 3 <= w.size(); ++i) s.trigrams.push_back(trigramKey(w.data() + i));
+        });
+    });
+    sort(s.words.begin(), s.words.end());
+    s.words.erase(unique(s.words.begin(), s.words.end()), s.words.end());
+    sort(s.trigrams.begin(), s.trigrams.end());
+    s.trigrams.erase(unique(s.trigrams.begin(), s.trigrams.end()), s.trigrams.end());
+    for (const string &w : s.words) index.words[w].push_back(doc);
+    for (uint32_t g : s.trigrams) index.trigrams[g].push_back(doc);
+}
+
+void rebuildTextIndex(ToDoList &list) {
+    if (!list.text.enabled) return;
+    MetricTimer timer(METRIC_TEXT_INDEX);
+    timer.rows = list.tasks.size();
+    TextIndex &index = list.text;
+    index.clear();
+    index.docTask.reserve(list.tasks.size());
+    index.docOfTask.reserve(list.tasks.size());
+    TextScratch scratch;
+    // Last row first, so that of rows sharing an id the first one (the one
+    // findRow returns) is what's indexed
+    for (size_t r = list.tasks.size(); r-- > 0;) addTextDocument(index, list, list.tasks[r], scratch);
+}
+
+void compactTextIndex(ToDoList &list) {
+    if (list.text.stale > 4096 && list.text.stale * 2 > list.text.docTask.size()) rebuildTextIndex(list);
+}
+
+void indexTaskText(ToDoList &list, const Task &t) {
+    if (!list.text.enabled) return;
+    TextScratch scratch;
+    addTextDocument(list.text, list, t, scratch);
+    compactTextIndex(list);
+}
+
+void unindexTaskText(ToDoList &list, int id) {
+    if (list.text.enabled) forgetTextDocument(list.text, id);
+}
+
+void enableTextIndex(ToDoList &list) {
+    if (list.text.enabled) return;
+    list.text.enabled = true;
+    rebuildTextIndex(list);
+}
+
+// Where in `text` the lowercase `word` occurs, ignoring case, from `from`.
+size_t findFolded(string_view text, const string &word, size_t from) {
+    for (size_t at = from; at + word.size() <= text.size(); ++at) {
+        size_t i = 0;
+        while (i < word.size() && foldByte(text[at + i]) == word[i]) ++i;
+        if (i == word.size()) return at;
+    }
+    return string_view::npos;
+}
+
+// How well one query word matches a task: 3 for a whole word in the name,
+// 2 for part of a word in the name, 1.5 and 1 for the same elsewhere, 0
+// for no match.
+double wordMatch(const ToDoList &list, const Task &t, const string &word) {
+    double best = 0, weight = 2;   // the name comes first
+    forEachTaskText(list, t, [&](string_view text) {
+        for (size_t at = findFolded(text, word, 0); at != string_view::npos && best < weight * 1.5;
+             at = findFolded(text, word, at + 1)) {
+            size_t end = at + word.size();
+            bool whole = (at == 0 || !isWordByte(text[at - 1])) && (end == text.size() || !isWordByte(text[end]));
+            if (whole) best = max(best, weight * 1.5);
+            else if (word.size() >= 3) best = max(best, weight);
+        }
+        weight = 1;
+    });
+    return best;
+}
+
+const vector<uint32_t> NO_DOCUMENTS;
+
+// The shortest posting list every document containing `word` is on.
+const vector<uint32_t> &rarestPostings(const TextIndex &index, const string &word) {
+    if (word.size() < 3) {
+        auto it = index.words.find(word);
+        return it == index.words.end() ? NO_DOCUMENTS : it->second;
+    }
+    const vector<uint32_t> *rarest = nullptr;
+    for (size_t i = 0; i + 3 <= word.size(); ++i) {
+        auto it = index.trigrams.find(trigramKey(word.data() + i));
+        if (it == index.trigrams.end()) return NO_DOCUMENTS;
+        if (!rarest || it->second.size() < rarest->size()) rarest = &it->second;
+    }
+    return *rarest;
+}
+
+vector<SearchHit> searchTasks(const ToDoList &list, string_view query, size_t limit) {
+    MetricTimer timer(METRIC_SEARCH);
+    vector<string> words;
+    string word;
+    forEachWord(query, word, [&words](const string &w) { words.push_back(w); });
+    sort(words.begin(), words.end());
+    words.erase(unique(words.begin(), words.end()), words.end());
+    vector<SearchHit> hits;
+    if (words.empty()) return hits;
+
+    // Every query word has to match; rare ones count more
+    vector<double> rarity(words.size(), 1.0);
+    auto score = [&](size_t row) {
+        double total = 0;
+        for (size_t w = 0; w < words.size(); ++w) {
+            double match = wordMatch(list, list.tasks[row], words[w]);
+            if (match == 0) return;
+            total += rarity[w] * match;
+        }
+        hits.push_back({list.tasks[row].id, row, total});
+    };
+
+    const TextIndex &index = list.text;
+    if (!index.enabled) {
+        timer.rows = list.tasks.size();
+        for (size_t r = 0; r < list.tasks.size(); ++r) score(r);
+    } else {
+        double live = (double)(index.docTask.size() - index.stale);
+        size_t driver = 0;
+        for (size_t w = 0; w < words.size(); ++w) {
+            auto exact = index.words.find(words[w]);
+            size_t seen = exact != index.words.end() ? exact->second.size() : rarestPostings(index, words[w]).size();
+            rarity[w] = log(1 + live / (1.0 + seen));
+            if (rarestPostings(index, words[w]).size() < rarestPostings(index, words[driver]).size()) driver = w;
+        }
+        // Candidates: documents on all of the driving word's trigram lists
+        const string &first = words[driver];
+        vector<uint32_t> docs = rarestPostings(index, first);
+        for (size_t i = 0; i + 3 <= first.size() && !docs.empty(); ++i) {
+            const vector<uint32_t> &other = index.trigrams.at(trigramKey(first.data() + i));
+            if (&other == &rarestPostings(index, first)) continue;
+            docs.erase(remove_if(docs.begin(), docs.end(),
+                                 [&other](uint32_t d) { return !binary_search(other.begin(), other.end(), d); }),
+                       docs.end());
+        }
+        timer.rows = docs.size();
+        for (uint32_t d : docs) {
+            if (index.docTask[d] < 0) continue;
+            size_t row = findRow(list, index.docTask[d]);
+            if (row != NO_ROW) score(row);
+        }
+    }
+
+    size_t keep = min(limit, hits.size());
+    partial_sort(hits.begin(), hits.begin() + keep, hits.end(), [](const SearchHit &a, const SearchHit &b) {
+        return a.score != b.score ? a.score > b.score : a.id < b.id;
+    });
+    hits.resize(keep);
+    return hits;
+}
+
+
+// ---------- Shared boards ----------
+
+void resetBoard(TaskBoard &board, ToDoList &&list) {
+    lock_guard<mutex> guard(board.writeLock);
+    auto first = make_shared<BoardVersion>();
+    first->number = atomic_load(&board.current)->number + 1;
+    first->list = move(list);
+    board.copies = {first};
+    board.edits.clear();
+    board.firstEdit = first->number;
+    atomic_store(&board.current, first);
+}
+
+shared_ptr<const BoardVersion> readBoard(const TaskBoard &board) {
+    return atomic_load(&board.current);
+}
+
+// A copy no reader can see, to run the next edit on: an idle one if there
+// is one, else a new one while there's room, else the first to come free.
+shared_ptr<BoardVersion> spareCopy(TaskBoard &board, const shared_ptr<BoardVersion> &current) {
+    while (true) {
+        for (const auto &copy : board.copies) {
+            // Held by `copies` alone: readers only ever get the current
+            // version, so nobody can pick this one up again
+            if (copy != current && copy.use_count() == 1) {
+                atomic_thread_fence(memory_order_acquire);   // after the last reader let go
+                return copy;
+            }
+        }
+        if (board.copies.size() < max<size_t>(board.maxCopies, 2)) {
+            board.copies.push_back(make_shared<BoardVersion>(*current));
+            return board.copies.back();
+        }
+        this_thread::yield();
+    }
+}
+
+uint64_t editBoard(TaskBoard &board, BoardEdit edit) {
+    lock_guard<mutex> guard(board.writeLock);
+    shared_ptr<BoardVersion> current = atomic_load(&board.current);
+    if (board.copies.empty()) {
+        board.copies.push_back(current);
+        board.firstEdit = current->number;
+    }
+    shared_ptr<BoardVersion> next = spareCopy(board, current);
+    try {
+        for (uint64_t n = next->number; n < current->number; ++n)
+            board.edits[n - board.firstEdit](next->list, next->undo);
+        next->undo.journal = board.journal;
+        next->undo.warn = board.warn;
+        edit(next->list, next->undo);
+    } catch (...) {
+        // Half an edit: this copy can't be caught up any more
+        board.copies.erase(find(board.copies.begin(), board.copies.end(), next));
+        throw;
+    }
+    next->undo.journal = nullptr;
+    next->undo.warn = nullptr;
+    next->number = current->number + 1;
+    board.edits.push_back(move(edit));
+    atomic_store(&board.current, next);
+
+    // Drop the edits every copy has already seen
+    uint64_t oldest = next->number;
+    for (const auto &copy : board.copies) oldest = min(oldest, copy->number);
+    for (; board.firstEdit < oldest; ++board.firstEdit) board.edits.pop_front();
+    return next->number;
+}
+
+
+// ---------- Workspaces ----------
+
+bool validBoardName(string_view name) {
+    if (name.empty() || name.size() > 64 || name[0] == '.') return false;
+    for (char c : name)
+        if (!isalnum((unsigned char)c) && c != '-' && c != '_' && c != '.') return false;
+    return true;
+}
+
+void runWorkspaceWorker(WorkspaceWorker &w) {
+    unique_lock<mutex> hold(w.lock);
+    while (true) {
+        w.wake.wait(hold, [&w] { return w.stop || !w.jobs.empty(); });
+        if (w.jobs.empty()) return;   // stopped, and everything queued is done
+        function<void()> job = move(w.jobs.front());
+        w.jobs.pop_front();
+        hold.unlock();
+        job();
+        hold.lock();
+    }
+}
+
+void postToWorker(Workspace &ws, unsigned worker, function<void()> job) {
+    WorkspaceWorker &w = *ws.workers[worker];
+    {
+        lock_guard<mutex> guard(w.lock);
+        w.jobs.push_back(move(job));
+    }
+    w.wake.notify_one();
+}
+
+// Under ws.lock.
+WorkspaceBoard &registerBoard(Workspace &ws, const string &name) {
+    unique_ptr<WorkspaceBoard> &slot = ws.boards[name];
+    if (!slot) {
+        slot = make_unique<WorkspaceBoard>();
+        slot->name = name;
+        slot->worker = (unsigned)(hash<string>()(name) % ws.workers.size());
+    }
+    return *slot;
+}
+
+bool openWorkspace(Workspace &ws, const string &directory, unsigned workers, string &error) {
+    namespace fs = std::filesystem;
+    error_code ec;
+    fs::create_directories(directory, ec);
+    if (!fs::is_directory(directory, ec)) {
+        error = "can't use " + directory + " as a directory";
+        return false;
+    }
+    ws.directory = directory;
+    if (workers == 0) workers = max(1u, thread::hardware_concurrency());
+    for (unsigned i = 0; i < workers; ++i) ws.workers.push_back(make_unique<WorkspaceWorker>());
+
+    lock_guard<mutex> guard(ws.lock);
+    for (const auto &entry : fs::directory_iterator(directory, ec)) {
+        string ext = entry.path().extension().string(), name = entry.path().stem().string();
+        if ((ext != ".tbs" && ext != ".csv") || !entry.is_regular_file(ec) || !validBoardName(name)) continue;
+        WorkspaceBoard &board = registerBoard(ws, name);
+        if (board.path.empty() || fs::last_write_time(entry.path(), ec) > fs::last_write_time(board.path, ec))
+            board.path = entry.path().string();
+    }
+    for (auto &w : ws.workers) w->thread = thread(runWorkspaceWorker, ref(*w));
+    return true;
+}
+
+// Reads a board, on its worker.
+void loadBoard(Workspace &ws, WorkspaceBoard &board) {
+    board.list = ToDoList();
+    board.list.name = board.name;
+    board.undo = UndoLog();
+    board.undo.budgetBytes = ws.undoBudgetBytes;
+    board.error.clear();
+    if (!board.path.empty()) {
+        bool ok;
+        if (board.path.size() > 4 && board.path.compare(board.path.size() - 4, 4, ".tbs") == 0) {
+            ok = readSnapshot(board.list, board.path, board.error);
+        } else {
+            CSVLoadStats stats;
+            ok = loadCSVMapped(board.list, board.path, stats, false, 1);   // the workers are the parallelism
+            if (!ok) board.error = "file not found";
+            else if (!stats.malformedRows.empty() && ws.warn)
+                ws.warn(board.path + ": skipped " + to_string(stats.malformedRows.size()) + " malformed row(s)");
+        }
+        if (!ok) {
+            if (ws.warn) ws.warn("Could not read board " + board.name + " from " + board.path + ": " + board.error);
+            board.list = ToDoList();
+            board.list.name = board.name;
+        }
+    }
+    board.savedVersion = board.list.version;
+    // Tasks plus their share of the indexes and the column store
+    size_t bytes = 0;
+    for (const Task &t : board.list.tasks) bytes += approxBytes(t) + 96;
+    board.bytesPerTask = board.list.tasks.empty() ? 256 : bytes / board.list.tasks.size();
+    lock_guard<mutex> guard(ws.lock);
+    board.loaded = true;
+    ++ws.loads;
+}
+
+// Writes a changed board back as <directory>/<name>.tbs. False if that failed.
+bool saveBoard(Workspace &ws, WorkspaceBoard &board) {
+    if (!board.error.empty() || board.list.version == board.savedVersion) return true;
+    string path = (std::filesystem::path(ws.directory) / (board.name + ".tbs")).string();
+    if (!writeSnapshot(board.list, path)) {
+        if (ws.warn) ws.warn("Could not save board " + board.name + " to " + path);
+        return false;
+    }
+    board.path = path;
+    board.savedVersion = board.list.version;
+    return true;
+}
+
+// Unloads a board picked by touchBoard, on its worker, unless it has been
+// used since. A board that can't be saved stays loaded.
+void unloadBoard(Workspace &ws, WorkspaceBoard &board, uint64_t lastUse) {
+    {
+        lock_guard<mutex> guard(ws.lock);
+        board.evicting = false;
+        if (!board.loaded || board.lastUse != lastUse) return;
+    }
+    if (!saveBoard(ws, board)) return;
+    board.list = ToDoList();
+    board.undo = UndoLog();
+    lock_guard<mutex> guard(ws.lock);
+    board.loaded = false;
+    ws.usedBytes -= board.bytes;
+    board.bytes = 0;
+    ++ws.evictions;
+}
+
+// After a job: updates the board's size and age, then, while the
+// workspace is over budget, has the least recently used boards unloaded.
+void touchBoard(Workspace &ws, WorkspaceBoard &board) {
+    size_t bytes = sizeof(WorkspaceBoard) + board.list.tasks.size() * board.bytesPerTask + board.undo.bytes;
+    vector<pair<WorkspaceBoard *, uint64_t>> victims;
+    {
+        lock_guard<mutex> guard(ws.lock);
+        ws.usedBytes = ws.usedBytes - board.bytes + bytes;
+        board.bytes = bytes;
+        board.lastUse = ++ws.clock;
+        if (ws.usedBytes > ws.budgetBytes) {
+            vector<WorkspaceBoard *> cold;
+            for (const auto &entry : ws.boards) {
+                WorkspaceBoard *b = entry.second.get();
+                if (b != &board && b->loaded && !b->evicting) cold.push_back(b);
+            }
+            sort(cold.begin(), cold.end(), [](WorkspaceBoard *a, WorkspaceBoard *b) { return a->lastUse < b->lastUse; });
+            size_t freeing = 0;
+            for (WorkspaceBoard *b : cold) {
+                if (ws.usedBytes - freeing <= ws.budgetBytes) break;
+                b->evicting = true;
+                freeing += b->bytes;
+                victims.push_back({b, b->lastUse});
+            }
+        }
+    }
+    for (const auto &victim : victims)
+        postToWorker(ws, victim.first->worker, [&ws, victim] { unloadBoard(ws, *victim.first, victim.second); });
+}
+
+bool postToBoard(Workspace &ws, const string &name, BoardJob job) {
+    if (!validBoardName(name) || ws.workers.empty()) return false;
+    WorkspaceBoard *board;
+    {
+        lock_guard<mutex> guard(ws.lock);
+        board = &registerBoard(ws, name);
+    }
+    postToWorker(ws, board->worker, [&ws, board, job = move(job)] {
+        // Only this worker changes `loaded`, so it can read it unlocked
+        if (!board->loaded) loadBoard(ws, *board);
+        job(*board);
+        touchBoard(ws, *board);
+    });
+    return true;
+}
+
+void closeWorkspace(Workspace &ws) {
+    for (auto &w : ws.workers) {
+        lock_guard<mutex> guard(w->lock);
+        w->stop = true;
+        w->wake.notify_one();
+    }
+    for (auto &w : ws.workers)
+        if (w->thread.joinable()) w->thread.join();
+    ws.workers.clear();
+    for (auto &entry : ws.boards)
+        if (entry.second->loaded) saveBoard(ws, *entry.second);
+}
+
+WorkspaceStats workspaceStats(Workspace &ws) {
+    lock_guard<mutex> guard(ws.lock);
+    WorkspaceStats stats;
+    stats.boards = ws.boards.size();
+    for (const auto &entry : ws.boards) stats.loaded += entry.second->loaded;
+    stats.usedBytes = ws.usedBytes;
+    stats.loads = ws.loads;
+    stats.evictions = ws.evictions;
+    return stats;
+}
+
+bool soonerMatch(const WorkspaceMatch &a, const WorkspaceMatch &b) {
+    if (a.deadlineMinutes != b.deadlineMinutes) return a.deadlineMinutes < b.deadlineMinutes;
+    if (a.board != b.board) return a.board < b.board;
+    return a.id < b.id;
+}
+
+vector<WorkspaceMatch> matchTasks(const ToDoList &list, const string &board, const FilterExpr &expr, size_t limit) {
+    vector<WorkspaceMatch> found;
+    const ColumnStore &cols = columnsOf(list);
+    FilterNode plan;
+    string error;
+    if (!compileFilter(expr, list, cols, plan, error)) return found;
+    RowBitmap all(cols.rows, true), matched(cols.rows);
+    {
+        MetricTimer timer(METRIC_FILTER);
+        timer.rows = cols.rows;
+        runFilter(plan, all, matched);
+    }
+    vector<size_t> rows;
+    matched.forEach([&rows](size_t r) { rows.push_back(r); });
+    auto sooner = [&list](size_t a, size_t b) {
+        const Task &x = list.tasks[a], &y = list.tasks[b];
+        return x.deadlineMinutes != y.deadlineMinutes ? x.deadlineMinutes < y.deadlineMinutes : x.id < y.id;
+    };
+    size_t keep = min(limit, rows.size());
+    partial_sort(rows.begin(), rows.begin() + keep, rows.end(), sooner);
+    found.reserve(keep);
+    for (size_t i = 0; i < keep; ++i) {
+        const Task &t = list.tasks[rows[i]];
+        found.push_back({board, t.id, t.name, list.priorities.text(t.priority), t.deadline,
+                         list.statuses.text(t.status), t.deadlineMinutes});
+    }
+    return found;
+}
+
+void mergeMatches(vector<WorkspaceMatch> &matches, size_t limit) {
+    size_t keep = min(limit, matches.size());
+    partial_sort(matches.begin(), matches.begin() + keep, matches.end(), soonerMatch);
+    matches.resize(keep);
+}
+
+// One query's progress across the boards.
+struct WorkspaceQuery {
+    FilterExpr expr;
+    size_t limit = 0;
+    mutex lock;
+    size_t waiting = 0;   // boards still to report
+    vector<WorkspaceMatch> matches;
+    WorkspaceQueryDone done;
+};
+
+void queryWorkspaceAsync(Workspace &ws, const string &expression, size_t limit, WorkspaceQueryDone done) {
+    auto query = make_shared<WorkspaceQuery>();
+    string error;
+    if (!parseFilterExpr(expression, query->expr, error)) return done({}, error);
+    vector<string> names;
+    {
+        lock_guard<mutex> guard(ws.lock);
+        for (const auto &entry : ws.boards) names.push_back(entry.first);
+    }
+    if (names.empty()) return done({}, "");
+    query->limit = limit;
+    query->waiting = names.size();
+    query->done = move(done);
+    for (const string &name : names) {
+        postToBoard(ws, name, [query](WorkspaceBoard &board) {
+            vector<WorkspaceMatch> found;
+            if (board.error.empty()) found = matchTasks(board.list, board.name, query->expr, query->limit);
+            {
+                lock_guard<mutex> guard(query->lock);
+                move(found.begin(), found.end(), back_inserter(query->matches));
+                if (--query->waiting > 0) return;
+            }
+            // The last board in: every other one has let go of the matches
+            mergeMatches(query->matches, query->limit);
+            query->done(move(query->matches), "");
+        });
+    }
+}
+
+bool queryWorkspace(Workspace &ws, const string &expression, size_t limit, vector<WorkspaceMatch> &out, string &error) {
+    promise<void> finished;
+    future<void> ready = finished.get_future();
+    queryWorkspaceAsync(ws, expression, limit, [&](vector<WorkspaceMatch> &&matches, const string &e) {
+        out = move(matches);
+        error = e;
+        finished.set_value();
+    });
+    ready.wait();
+    return error.empty();
+}
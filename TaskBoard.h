@@ -0,0 +1,1427 @@
+// The task-board engine behind ToDoList: tasks, typed cells, sorting,
+// filters, scheduling, undo, CSV/snapshot files and the journal, with no
+// console I/O. Functions report problems through their return value and an
+// `error` string (or a warn callback for things noticed on other threads).
+//
+// Thread safety: a ToDoList and the functions taking one are the
+// single-threaded core; any number of threads may read the same list at
+// once, but not while it's being edited. TaskBoard wraps one for sharing:
+// readers get immutable versions and never wait, writers take turns. A
+// Workspace holds many boards, each looked after by one worker thread.
+#ifndef TASKBOARD_H
+#define TASKBOARD_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bitset>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <future>
+#include <iosfwd>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <queue>
+#include <set>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+enum DataType { DT_INT, DT_STRING, DT_BOOL, DT_FLOAT, DT_DATE, DT_LINK};
+
+
+// ---------- Dates ----------
+
+// Days since 1970-01-01 for a proleptic Gregorian date (Howard Hinnant's
+// days_from_civil), so dates can be compared as plain integers.
+long long daysFromCivil(int y, int m, int d);
+
+inline bool isLeapYear(int y) { return (y % 4 == 0 && y % 100 != 0) || y % 400 == 0; }
+
+int daysInMonth(int y, int m);
+
+// Parses "dd/mm/yyyy hh:mm" (day, month and hour may be one digit) into
+// minutes since 01/01/1970 00:00 on the wall clock. No istringstream, no
+// mktime, and out-of-range parts (31/02, 25:00, ...) are rejected.
+bool parseDateTime(std::string_view s, long long &minutes);
+
+// Inverse of daysFromCivil.
+void civilFromDays(long long z, int &y, int &m, int &d);
+
+// Writes minutes from parseDateTime back as "d/m/yyyy h:mm", the style
+// used throughout Syllabus.csv (no leading zeros except on minutes).
+// Writes the date into buf and returns its length.
+size_t formatDateTimeTo(char *buf, size_t size, long long minutes);
+
+std::string formatDateTime(long long minutes);
+
+// The local time right now, on the same scale as parseDateTime.
+long long nowWallMinutes();
+
+
+// ---------- Instrumentation ----------
+// Every timed operation keeps a count, totals (rows, bytes, allocations)
+// and a latency histogram with 16 buckets per power of two, so any
+// percentile is known to within about 6% with a fixed 8 KB per operation
+// and no sorting of samples. Recording is a couple of clock reads and
+// relaxed atomic adds; see getStats (menu 11) for the table and
+// metricsJSON for the dump.
+
+enum Metric {
+    METRIC_CSV_READ, METRIC_CSV_READ_MAPPED, METRIC_CSV_WRITE, METRIC_SNAPSHOT_READ,
+    METRIC_SNAPSHOT_WRITE, METRIC_JOURNAL_FLUSH, METRIC_ADD_TASKS, METRIC_REMOVE_ROWS,
+    METRIC_COLUMNS, METRIC_SORT, METRIC_FILTER, METRIC_SCHEDULE, METRIC_ALERTS,
+    METRIC_PRINT, METRIC_INDEX_REBUILD, METRIC_UNDO_RECORD, METRIC_UNDO, METRIC_SEARCH,
+    METRIC_TEXT_INDEX, METRIC_COUNT
+};
+const char *const METRIC_NAMES[METRIC_COUNT] = {
+    "csv/read", "csv/read-mapped", "csv/write", "snapshot/read",
+    "snapshot/write", "journal/flush", "tasks/add", "tasks/remove",
+    "columns/add-delete", "sort", "filter", "schedule", "alerts",
+    "print", "indexes/rebuild", "undo/record", "undo/revert", "search",
+    "text-index/rebuild"
+};
+
+const int LATENCY_SUB_BITS = 4;
+const int LATENCY_BUCKETS = (64 - LATENCY_SUB_BITS + 1) << LATENCY_SUB_BITS;
+
+inline int latencyBucket(uint64_t ns) {
+    const uint64_t sub = 1u << LATENCY_SUB_BITS;
+    if (ns < sub) return (int)ns;
+#ifdef _MSC_VER
+    int e = 0;
+    while (ns >> (e + 1)) ++e;
+#else
+    int e = 63 - __builtin_clzll(ns);
+#endif
+    int shift = e - LATENCY_SUB_BITS;
+    return (int)(((shift + 1) << LATENCY_SUB_BITS) + ((ns >> shift) & (sub - 1)));
+}
+
+// The largest value that lands in `bucket`.
+inline uint64_t latencyBucketTop(int bucket) {
+    const int sub = 1 << LATENCY_SUB_BITS;
+    if (bucket < sub) return bucket;
+    int shift = (bucket >> LATENCY_SUB_BITS) - 1;
+    uint64_t low = (uint64_t)(sub + (bucket & (sub - 1))) << shift;
+    return low + ((1ull << shift) - 1);
+}
+
+struct MetricStats {
+    std::atomic<uint64_t> count{0}, totalNs{0}, maxNs{0};
+    std::atomic<uint64_t> rows{0}, bytesIn{0}, bytesOut{0}, allocs{0}, allocBytes{0};
+    std::array<std::atomic<uint64_t>, LATENCY_BUCKETS> latency{};
+
+    void record(uint64_t ns) {
+        count.fetch_add(1, std::memory_order_relaxed);
+        totalNs.fetch_add(ns, std::memory_order_relaxed);
+        uint64_t prev = maxNs.load(std::memory_order_relaxed);
+        while (ns > prev && !maxNs.compare_exchange_weak(prev, ns, std::memory_order_relaxed)) {}
+        latency[latencyBucket(ns)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Smallest latency that at least `fraction` of the runs stayed under.
+    uint64_t percentileNs(double fraction) const {
+        uint64_t n = count.load(std::memory_order_relaxed);
+        if (n == 0) return 0;
+        uint64_t rank = std::max<uint64_t>(1, (uint64_t)std::ceil(fraction * n)), seen = 0;
+        for (int b = 0; b < LATENCY_BUCKETS; ++b) {
+            seen += latency[b].load(std::memory_order_relaxed);
+            if (seen >= rank) return std::min(latencyBucketTop(b), maxNs.load(std::memory_order_relaxed));
+        }
+        return maxNs.load(std::memory_order_relaxed);
+    }
+};
+
+extern MetricStats metrics[METRIC_COUNT];
+extern const std::chrono::steady_clock::time_point PROGRAM_START;
+
+// Heap allocations made by this thread, and by the whole program. The
+// program counts them in its own operator new (ToDoList.cpp does); without
+// one they stay 0.
+extern thread_local uint64_t threadAllocs, threadAllocBytes;
+extern std::atomic<uint64_t> totalAllocs, totalAllocBytes;
+
+// Times one run of an operation from construction to destruction. Set
+// rows/bytesIn/bytesOut before it goes out of scope.
+struct MetricTimer {
+    Metric metric;
+    uint64_t rows = 0, bytesIn = 0, bytesOut = 0;
+    uint64_t allocs0 = threadAllocs, allocBytes0 = threadAllocBytes;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    explicit MetricTimer(Metric m) : metric(m) {}
+    MetricTimer(const MetricTimer &) = delete;
+    MetricTimer &operator=(const MetricTimer &) = delete;
+    ~MetricTimer() {
+        uint64_t ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        MetricStats &s = metrics[metric];
+        s.record(ns);
+        s.rows.fetch_add(rows, std::memory_order_relaxed);
+        s.bytesIn.fetch_add(bytesIn, std::memory_order_relaxed);
+        s.bytesOut.fetch_add(bytesOut, std::memory_order_relaxed);
+        s.allocs.fetch_add(threadAllocs - allocs0, std::memory_order_relaxed);
+        s.allocBytes.fetch_add(threadAllocBytes - allocBytes0, std::memory_order_relaxed);
+    }
+};
+
+// The same numbers as printMetrics, as JSON, with times in microseconds.
+std::string metricsJSON();
+
+bool writeMetrics(const std::string &path);
+
+
+// ---------- Cells ----------
+
+// Immutable, reference-counted text. Copying a cell that holds one only
+// bumps the count, and links are interned so every cell pointing at the
+// same link shares one buffer.
+struct SharedText {
+    std::atomic<uint32_t> refs;
+    uint32_t length;
+    bool interned;
+
+    const char *chars() const { return reinterpret_cast<const char *>(this + 1); }
+    std::string_view view() const { return std::string_view(chars(), length); }
+
+    static SharedText *create(std::string_view s, bool interned = false) {
+        void *mem = ::operator new(sizeof(SharedText) + s.size());
+        SharedText *t = new (mem) SharedText();
+        t->refs.store(1, std::memory_order_relaxed);
+        t->length = (uint32_t)s.size();
+        t->interned = interned;
+        std::memcpy(reinterpret_cast<char *>(t + 1), s.data(), s.size());
+        return t;
+    }
+    static void destroy(SharedText *t) {
+        t->~SharedText();
+        ::operator delete(t);
+    }
+};
+
+SharedText *internText(std::string_view s);
+
+inline void retainText(SharedText *t) { t->refs.fetch_add(1, std::memory_order_relaxed); }
+
+void releaseText(SharedText *t);
+
+// A single typed value, packed into 16 bytes:
+//   - ints, floats, bools and canonical dates (as minutes, see
+//     parseDateTime) live directly in `data`;
+//   - text up to 14 bytes is stored inline, with no heap allocation;
+//   - longer text (and every link) is a pointer to a SharedText.
+// Dates that don't print back exactly as typed (e.g. "05/11/2026 09:50")
+// are kept as text so getAsString always returns what was entered.
+struct Cell {
+    Cell() : length(0), tag(DT_STRING | (STORE_INLINE << 4)) {}
+    Cell(const Cell &other) { copyBits(other); if (isShared()) retainText(sharedText()); }
+    Cell(Cell &&other) noexcept { copyBits(other); other.forget(); }
+    Cell &operator=(const Cell &other) {
+        if (this != &other) {
+            if (other.isShared()) retainText(other.sharedText());
+            clear();
+            copyBits(other);
+        }
+        return *this;
+    }
+    Cell &operator=(Cell &&other) noexcept {
+        if (this != &other) {
+            clear();
+            copyBits(other);
+            other.forget();
+        }
+        return *this;
+    }
+    ~Cell() { clear(); }
+
+    DataType type() const { return (DataType)(tag & 0x0F); }
+
+    void setValue(std::string_view val) { setText(DT_STRING, val); }
+    void setValue(const std::string &val) { setText(DT_STRING, val); }
+    void setValue(const char *val) { setText(DT_STRING, val); }
+    void setValue(int val) { setScalar(DT_INT, &val, sizeof(val)); }
+    void setValue(bool val) { setScalar(DT_BOOL, &val, sizeof(val)); }
+    void setValue(float val) { setScalar(DT_FLOAT, &val, sizeof(val)); }
+    void setDate(std::string_view val) {
+        long long minutes;
+        if (parseDateTime(val, minutes) && formatDateTime(minutes) == val) setDateMinutes(minutes);
+        else setText(DT_DATE, val);
+    }
+    void setDateMinutes(long long minutes) { setScalar(DT_DATE, &minutes, sizeof(minutes)); }
+    void setLink(std::string_view val) {
+        clear();
+        SharedText *t = internText(val);
+        std::memcpy(data, &t, sizeof(t));
+        tag = DT_LINK | (STORE_SHARED << 4);
+    }
+
+    int getInt() const { int v = 0; if (type() == DT_INT) std::memcpy(&v, data, sizeof(v)); return v; }
+    float getFloat() const { float v = 0; if (type() == DT_FLOAT) std::memcpy(&v, data, sizeof(v)); return v; }
+    bool getBool() const { bool v = false; if (type() == DT_BOOL) std::memcpy(&v, data, sizeof(v)); return v; }
+    // Date as minutes since 01/01/1970 00:00; false if this isn't a valid date.
+    bool getDateMinutes(long long &minutes) const {
+        if (type() != DT_DATE) return false;
+        if (storage() == STORE_VALUE) { std::memcpy(&minutes, data, sizeof(minutes)); return true; }
+        return parseDateTime(getText(), minutes);
+    }
+    // The stored text of string, link and non-canonical date cells.
+    std::string_view getText() const {
+        if (storage() == STORE_INLINE) return std::string_view(data, length);
+        if (storage() == STORE_SHARED) return sharedText()->view();
+        return std::string_view();
+    }
+
+    std::string getAsString() const {
+        switch (type()) {
+            case DT_INT: return std::to_string(getInt());
+            case DT_STRING: return std::string(getText());
+            case DT_BOOL: return getBool() ? "Yes" : "No";
+            case DT_FLOAT: return std::to_string(getFloat());
+            case DT_DATE: {
+                long long minutes;
+                if (storage() == STORE_VALUE && getDateMinutes(minutes)) return formatDateTime(minutes);
+                return std::string(getText());
+            }
+            case DT_LINK: return std::string(getText());
+        }
+        return "";
+    }
+
+private:
+    enum Storage : uint8_t { STORE_INLINE = 0, STORE_SHARED = 1, STORE_VALUE = 2 };
+    static const size_t INLINE_CAPACITY = 14;
+
+    char data[INLINE_CAPACITY];
+    uint8_t length;   // inline text length
+    uint8_t tag;      // DataType in the low nibble, Storage in the high one
+
+    Storage storage() const { return (Storage)(tag >> 4); }
+    bool isShared() const { return storage() == STORE_SHARED; }
+    SharedText *sharedText() const { SharedText *t; std::memcpy(&t, data, sizeof(t)); return t; }
+
+    void copyBits(const Cell &other) {
+        std::memcpy(data, other.data, sizeof(data));
+        length = other.length;
+        tag = other.tag;
+    }
+    // Becomes an empty string without releasing anything (after a move).
+    void forget() {
+        tag = DT_STRING | (STORE_INLINE << 4);
+        length = 0;
+    }
+    void clear() {
+        if (isShared()) releaseText(sharedText());
+        forget();
+    }
+    void setScalar(DataType t, const void *value, size_t size) {
+        clear();
+        std::memcpy(data, value, size);
+        tag = t | (STORE_VALUE << 4);
+    }
+    void setText(DataType t, std::string_view val) {
+        clear();
+        if (val.size() <= INLINE_CAPACITY) {
+            if (!val.empty()) std::memcpy(data, val.data(), val.size());
+            length = (uint8_t)val.size();
+            tag = t | (STORE_INLINE << 4);
+        } else {
+            SharedText *shared = SharedText::create(val);
+            std::memcpy(data, &shared, sizeof(shared));
+            tag = t | (STORE_SHARED << 4);
+        }
+    }
+};
+
+// Maps each distinct value of a low-cardinality text column (Priority,
+// Status) to a small integer code, so rows store, compare and count codes
+// instead of strings. Codes never change once handed out and unknown
+// values simply get new ones, so whatever a CSV contains is written back
+// unchanged.
+struct SymbolTable {
+    std::vector<std::string> values;
+    std::unordered_map<std::string, uint32_t> codes;
+
+    SymbolTable() {}
+    SymbolTable(std::initializer_list<const char *> seeds) {
+        for (const char *s : seeds) intern(s);
+    }
+
+    uint32_t intern(std::string_view s) {
+        std::string key(s);
+        auto it = codes.find(key);
+        if (it != codes.end()) return it->second;
+        uint32_t code = (uint32_t)values.size();
+        values.push_back(key);
+        codes.emplace(std::move(key), code);
+        return code;
+    }
+    bool find(std::string_view s, uint32_t &code) const {
+        auto it = codes.find(std::string(s));
+        if (it == codes.end()) return false;
+        code = it->second;
+        return true;
+    }
+    const std::string &text(uint32_t code) const { return values[code]; }
+    size_t size() const { return values.size(); }
+
+    // Rank of every code when the values are sorted as text, so sorting
+    // "alphabetically" can still compare integers.
+    std::vector<uint32_t> textOrder() const {
+        std::vector<uint32_t> byText(values.size());
+        std::iota(byText.begin(), byText.end(), 0);
+        std::sort(byText.begin(), byText.end(), [this](uint32_t a, uint32_t b) { return values[a] < values[b]; });
+        std::vector<uint32_t> rank(values.size());
+        for (uint32_t i = 0; i < byText.size(); ++i) rank[byText[i]] = i;
+        return rank;
+    }
+};
+
+// Every list starts with these symbols, so the common values have the
+// same code everywhere (and getPriorityValue can work from the code).
+enum : uint32_t { PRIORITY_HIGH = 0, PRIORITY_MEDIUM = 1, PRIORITY_LOW = 2 };
+enum : uint32_t { STATUS_PENDING = 0, STATUS_IN_PROGRESS = 1, STATUS_COMPLETED = 2 };
+
+inline SymbolTable prioritySymbols() { return SymbolTable{"High", "Medium", "Low"}; }
+inline SymbolTable statusSymbols() { return SymbolTable{"Pending", "In progress", "Completed"}; }
+
+// deadlineMinutes for a deadline that doesn't parse; sorts after every
+// real date and never raises an alert.
+const long long NO_DEADLINE = LLONG_MAX;
+
+struct Task {
+    int id;
+    uint32_t priority;   // code in ToDoList::priorities
+    uint32_t status;     // code in ToDoList::statuses
+    long long deadlineMinutes = NO_DEADLINE;   // parsed once, see setDeadline
+    std::string name;
+    std::string deadline;
+    std::vector<Cell> extraColumns;
+};
+
+// Keeps the deadline text and its parsed minutes together. Returns false
+// (and stores NO_DEADLINE) if the text isn't "dd/mm/yyyy hh:mm".
+bool setDeadline(Task &t, std::string_view text);
+
+
+// ---------- Typed values from text ----------
+// Used when loading CSV files, so numbers, flags and dates come back as
+// native INT/FLOAT/BOOL/DATE cells instead of strings.
+
+std::string dataTypeName(DataType t);
+
+bool parseDataTypeName(std::string_view s, DataType &t);
+
+// Whole-string integer: no spaces, no trailing junk.
+bool parseIntText(std::string_view s, int &out);
+
+bool parseFloatText(std::string_view s, float &out);
+
+// Accepts what getAsString writes (Yes/No) plus true/false, any case.
+bool parseBoolText(std::string_view s, bool &out);
+
+// Stores `text` in the cell as `type`. Text that doesn't fit the type
+// (or is empty) is kept as a string cell, so it still round-trips.
+void setCellFromText(Cell &c, DataType type, std::string_view text);
+
+
+// ---------- Delimiter scanning kernels ----------
+
+// Returns the first byte in [p, end) equal to a, b or c, or `end`.
+typedef const char *(*FindAnyKernel)(const char *p, const char *end, char a, char b, char c);
+// Adds the number of '"' and '\n' bytes in [p, end) to the counters.
+typedef void (*CountKernel)(const char *p, const char *end, size_t &quotes, size_t &newlines);
+
+struct ScanKernels {
+    const char *name;
+    FindAnyKernel findAny;
+    CountKernel count;
+};
+
+extern ScanKernels scanKernels;
+
+// Every kernel set this CPU can run, scalar first.
+std::vector<ScanKernels> availableScanKernels();
+
+// Splits one CSV line into fields, respecting double-quoted fields
+// that may contain commas or escaped quotes ("").
+std::vector<std::string> parseCSVLine(const std::string &line);
+
+// Wraps a field in quotes (escaping internal quotes) if it contains
+// a comma, quote, or newline, so CSV export/import round-trips safely.
+// One kernel pass decides whether quoting is needed at all; quoted
+// fields are then copied in runs between embedded quotes.
+std::string csvEscape(const std::string &field);
+
+// High > Medium > Low > anything else. Those three are always codes 0-2.
+int getPriorityValue(uint32_t priority);
+
+
+// ---------- Columnar store ----------
+// `tasks` stays the list's system of record (every edit and the CSV
+// format work row by row), but scans over a single field shouldn't drag
+// every fat Task row through the cache. The column store keeps one
+// contiguous array per field. Each field is built from the rows on its
+// own, the first time it's read after a change to it, and then shared
+// (read-only) until it changes again: a status scan after a rename
+// rebuilds the statuses and nothing else.
+
+// All strings of one column in a single buffer: row r is
+// chars[offsets[r] .. offsets[r + 1]).
+struct StringColumn {
+    std::vector<size_t> offsets = {0};
+    std::string chars;
+
+    void push(std::string_view s) {
+        chars += s;
+        offsets.push_back(chars.size());
+    }
+    std::string_view at(size_t r) const {
+        return std::string_view(chars.data() + offsets[r], offsets[r + 1] - offsets[r]);
+    }
+};
+
+// What a row holds in a typed extra column.
+enum CellState : uint8_t { CELL_TEXT = 0, CELL_NATIVE = 1, CELL_MISSING = 2 };
+
+// One custom column. Only the array matching `type` is filled; cells that
+// don't hold a native value (text left over from a CSV, or rows shorter
+// than the header) are marked in `state` and read from the row instead.
+struct ExtraColumn {
+    DataType type = DT_STRING;
+    std::vector<int> ints;
+    std::vector<float> floats;
+    std::vector<uint8_t> bools;
+    std::vector<long long> dates;   // minutes, see parseDateTime
+    StringColumn strings;           // DT_STRING / DT_LINK
+    std::vector<uint8_t> state;
+};
+
+// The fields the store builds one at a time: the fixed ones, then
+// custom column c as FIELD_EXTRAS + c.
+enum StoreField : size_t { FIELD_IDS, FIELD_NAMES, FIELD_PRIORITIES, FIELD_DEADLINES, FIELD_STATUSES, FIELD_EXTRAS };
+
+// One field's arrays; only those for its field are filled.
+struct FieldColumns {
+    size_t version = 0;                // see ToDoList::fieldVersions
+    std::vector<int> ids;
+    StringColumn text;                 // names, deadlines
+    std::vector<uint32_t> codes;       // priorities, statuses (symbol codes)
+    std::vector<long long> minutes;    // Task::deadlineMinutes
+    std::vector<uint8_t> flags;        // getPriorityValue, or status == "Completed"
+    ExtraColumn extra;
+};
+
+struct ToDoList;
+
+// A list's columns, from columnsOf. Each accessor builds its field if
+// it's out of date; what it returns stays valid until the list changes.
+struct ColumnStore {
+    const ToDoList *list = nullptr;
+    size_t rows = 0;
+
+    const std::vector<int> &ids() const { return field(FIELD_IDS).ids; }
+    const StringColumn &names() const { return field(FIELD_NAMES).text; }
+    const std::vector<uint32_t> &priorities() const { return field(FIELD_PRIORITIES).codes; }
+    const std::vector<uint8_t> &priorityRanks() const { return field(FIELD_PRIORITIES).flags; }
+    const StringColumn &deadlines() const { return field(FIELD_DEADLINES).text; }
+    const std::vector<long long> &deadlineMinutes() const { return field(FIELD_DEADLINES).minutes; }
+    const std::vector<uint32_t> &statuses() const { return field(FIELD_STATUSES).codes; }
+    const std::vector<uint8_t> &completed() const { return field(FIELD_STATUSES).flags; }
+    const ExtraColumn &extra(size_t column) const { return field(FIELD_EXTRAS + column).extra; }
+
+private:
+    const FieldColumns &field(size_t f) const;
+};
+
+
+// ---------- Scheduling heap ----------
+
+// What the scheduler orders a pending task by.
+struct ScheduleEntry {
+    long long deadline;   // Task::deadlineMinutes
+    int rank;             // getPriorityValue
+    int id;
+};
+
+// Earlier deadline first; on a tie, higher priority (High > Medium > Low),
+// then lower id so the order never depends on heap layout.
+inline bool runsBefore(const ScheduleEntry &a, const ScheduleEntry &b) {
+    if (a.deadline != b.deadline) return a.deadline < b.deadline;
+    if (a.rank != b.rank) return a.rank > b.rank;
+    return a.id < b.id;
+}
+
+// Pending tasks as a binary min-heap plus an id -> slot map, kept up to
+// date by the editing functions so a change costs O(log n) and "what's
+// next" never needs a rebuild.
+struct ScheduleHeap {
+    std::vector<ScheduleEntry> heap;
+    std::unordered_map<int, size_t> slot;   // task id -> index in heap
+
+    size_t size() const { return heap.size(); }
+    bool contains(int id) const { return slot.count(id) != 0; }
+
+    void clear() {
+        heap.clear();
+        slot.clear();
+    }
+
+    // O(n) heapify. If an id repeats, the first entry wins.
+    void build(std::vector<ScheduleEntry> entries) {
+        clear();
+        heap.reserve(entries.size());
+        slot.reserve(entries.size());
+        for (const auto &e : entries) {
+            if (!slot.emplace(e.id, heap.size()).second) continue;
+            heap.push_back(e);
+        }
+        for (size_t i = heap.size() / 2; i-- > 0;) siftDown(i);
+    }
+
+    // Adds the task, or moves it if its deadline or priority changed
+    // (decrease-key and increase-key alike).
+    void set(const ScheduleEntry &e) {
+        auto it = slot.find(e.id);
+        if (it == slot.end()) {
+            slot[e.id] = heap.size();
+            heap.push_back(e);
+            siftUp(heap.size() - 1);
+            return;
+        }
+        size_t i = it->second;
+        bool earlier = runsBefore(e, heap[i]);
+        heap[i] = e;
+        if (earlier) siftUp(i);
+        else siftDown(i);
+    }
+
+    void remove(int id) {
+        auto it = slot.find(id);
+        if (it == slot.end()) return;
+        size_t i = it->second;
+        slot.erase(it);
+        size_t last = heap.size() - 1;
+        if (i != last) {
+            place(i, heap[last]);
+            heap.pop_back();
+            siftUp(i);
+            siftDown(i);
+        } else {
+            heap.pop_back();
+        }
+    }
+
+    // The first k entries in run order, without touching the heap: walks
+    // it best-first with a small frontier queue, O(k log k).
+    std::vector<ScheduleEntry> peek(size_t k) const {
+        MetricTimer timer(METRIC_SCHEDULE);
+        std::vector<ScheduleEntry> out;
+        if (heap.empty() || k == 0) return out;
+        auto later = [this](size_t a, size_t b) { return runsBefore(heap[b], heap[a]); };
+        std::priority_queue<size_t, std::vector<size_t>, decltype(later)> frontier(later);
+        frontier.push(0);
+        while (!frontier.empty() && out.size() < k) {
+            size_t i = frontier.top(); frontier.pop();
+            out.push_back(heap[i]);
+            if (2 * i + 1 < heap.size()) frontier.push(2 * i + 1);
+            if (2 * i + 2 < heap.size()) frontier.push(2 * i + 2);
+        }
+        timer.rows = out.size();
+        return out;
+    }
+
+private:
+    void place(size_t i, const ScheduleEntry &e) {
+        heap[i] = e;
+        slot[e.id] = i;
+    }
+    void siftUp(size_t i) {
+        ScheduleEntry e = heap[i];
+        while (i > 0) {
+            size_t parent = (i - 1) / 2;
+            if (!runsBefore(e, heap[parent])) break;
+            place(i, heap[parent]);
+            i = parent;
+        }
+        place(i, e);
+    }
+    void siftDown(size_t i) {
+        ScheduleEntry e = heap[i];
+        size_t n = heap.size();
+        while (true) {
+            size_t child = 2 * i + 1;
+            if (child >= n) break;
+            if (child + 1 < n && runsBefore(heap[child + 1], heap[child])) ++child;
+            if (!runsBefore(heap[child], e)) break;
+            place(i, heap[child]);
+            i = child;
+        }
+        place(i, e);
+    }
+};
+
+// Pending tasks with a readable deadline, ordered by deadline, so each
+// alert bucket is one range query instead of a scan of the board.
+struct DeadlineIndex {
+    std::set<std::pair<long long, int>> byDeadline;   // (deadline minutes, task id)
+    std::unordered_map<int, long long> deadlineOf;
+
+    void clear() {
+        byDeadline.clear();
+        deadlineOf.clear();
+    }
+    void update(int id, long long deadline) {
+        remove(id);
+        byDeadline.insert({deadline, id});
+        deadlineOf[id] = deadline;
+    }
+    void remove(int id) {
+        auto it = deadlineOf.find(id);
+        if (it == deadlineOf.end()) return;
+        byDeadline.erase({it->second, id});
+        deadlineOf.erase(it);
+    }
+    // First entry with a deadline >= `from`.
+    std::set<std::pair<long long, int>>::const_iterator from(long long minutes) const {
+        return byDeadline.lower_bound({minutes, INT_MIN});
+    }
+};
+
+// Words and trigrams of every task's name and STRING cells, for
+// searchTasks. Off until enableTextIndex; from then on every edit keeps it
+// current. Each indexed version of a task's text is a document with its
+// own number: an edit gives the task a new document rather than patching
+// posting lists, and the old one is skipped until the index is next
+// rebuilt. Documents are numbered in order, so posting lists stay sorted.
+struct TextIndex {
+    bool enabled = false;
+    std::vector<int> docTask;                      // document -> task id, or -1 once replaced
+    std::unordered_map<int, uint32_t> docOfTask;   // task id -> its current document
+    std::unordered_map<std::string, std::vector<uint32_t>> words;   // lowercase word -> documents
+    std::unordered_map<uint32_t, std::vector<uint32_t>> trigrams;   // three bytes of a lowercase word -> documents
+    size_t stale = 0;                              // documents that are -1
+
+    void clear() {
+        docTask.clear();
+        docOfTask.clear();
+        words.clear();
+        trigrams.clear();
+        stale = 0;
+    }
+};
+
+// A list's built fields, by StoreField. Readers on several threads may
+// fill them in at once (see ColumnStore), so they're only touched under
+// `lock`. Copies share the built fields.
+struct ColumnCache {
+    mutable std::mutex lock;
+    std::vector<std::shared_ptr<const FieldColumns>> fields;
+
+    ColumnCache() {}
+    ColumnCache(const ColumnCache &other) {
+        std::lock_guard<std::mutex> guard(other.lock);
+        fields = other.fields;
+    }
+    ColumnCache &operator=(const ColumnCache &other) {
+        if (this == &other) return *this;
+        std::vector<std::shared_ptr<const FieldColumns>> copy;
+        {
+            std::lock_guard<std::mutex> guard(other.lock);
+            copy = other.fields;
+        }
+        std::lock_guard<std::mutex> guard(lock);
+        fields.swap(copy);
+        return *this;
+    }
+};
+
+struct ToDoList {
+    std::string name;
+    std::vector<std::string> columnNames;
+    std::vector<DataType> columnTypes;
+    std::vector<Task> tasks;
+    int nextId = 1;
+    SymbolTable priorities = prioritySymbols();
+    SymbolTable statuses = statusSymbols();
+
+    // `version` changes on every edit. `shapeVersion` changes when rows
+    // or columns come, go or move; an edit to one task in place only
+    // moves the entries of fieldVersions (by StoreField) it touched. The
+    // column store rebuilds a field whose versions no longer match.
+    size_t version = 0;
+    size_t shapeVersion = 0;
+    std::vector<size_t> fieldVersions;
+    mutable ColumnCache columns;
+
+    ScheduleHeap schedule;   // pending tasks, see scheduleTask
+    DeadlineIndex dueIndex;  // same tasks, by deadline, for alerts
+    TextIndex text;          // see indexTaskText
+
+    // Point lookups; see findRow / findColumn. If an id or column name
+    // repeats, the first one wins, as with the old linear scans.
+    std::unordered_map<int, size_t> rowOfId;
+    std::unordered_map<std::string, size_t> columnOfName;
+};
+
+// Call after changing a list's rows or columns.
+void markChanged(ToDoList &list);
+
+// Call instead after editing one task in place, `before` being what it
+// held: only the fields that differ are rebuilt in the column store.
+void markTaskChanged(ToDoList &list, const Task &before, const Task &after);
+
+// The list's column store; fields are built as they're read.
+ColumnStore columnsOf(const ToDoList &list);
+
+// Puts a task in the scheduling heap and deadline index, moves it after
+// an edit, or takes it out once it's completed.
+void scheduleTask(ToDoList &list, const Task &t);
+
+void unscheduleTask(ToDoList &list, int id);
+
+// Indexes a task's text again after it was added or its name or a STRING
+// cell changed; nothing while the list's text index is off.
+void indexTaskText(ToDoList &list, const Task &t);
+
+// Drops a task's text from the index. Safe mid-way through moving rows:
+// it never re-reads them, so call compactTextIndex once they're settled.
+void unindexTaskText(ToDoList &list, int id);
+
+// Rebuilds the index once most of it is for text that's since been
+// replaced or removed. Reads every row.
+void compactTextIndex(ToDoList &list);
+
+// Re-indexes every row, e.g. after a STRING column came or went; nothing
+// while the index is off.
+void rebuildTextIndex(ToDoList &list);
+
+// Runs work(0) ... work(threads - 1), work(0) on the calling thread.
+template <class F>
+void runOnThreads(unsigned threads, F &&work) {
+    std::vector<std::thread> pool;
+    for (unsigned i = 1; i < threads; ++i) pool.emplace_back(work, i);
+    work(0u);
+    for (auto &t : pool) t.join();
+}
+
+// Rebuilds the scheduling heap from every row.
+void rebuildScheduleHeap(ToDoList &list);
+
+// Rebuilds the deadline index from every row. The set is built from a
+// sorted vector, which is linear, instead of n random inserts. `sorted`,
+// if given, is that vector already checked and in order (from a snapshot).
+void rebuildDeadlineIndex(ToDoList &list, const std::vector<std::pair<long long, int>> *sorted = nullptr);
+
+
+// ---------- Lookups ----------
+
+const size_t NO_ROW = SIZE_MAX;
+
+// Row of task `id`, or NO_ROW. O(1).
+size_t findRow(const ToDoList &list, int id);
+
+// Index of a custom column, or -1.
+int findColumn(const ToDoList &list, const std::string &name);
+
+// Call after rows are removed or reordered.
+void reindexRows(ToDoList &list);
+
+// Call after columns are added or removed.
+void reindexColumns(ToDoList &list);
+
+// Everything derived from the rows and columns; used after loading a file.
+// The three row indexes are independent, so big boards build them at once.
+void rebuildIndexes(ToDoList &list, const std::vector<std::pair<long long, int>> *sortedDeadlines = nullptr);
+
+// Alert buckets, tightest first. A task enters a bucket once its deadline
+// is `within` minutes away.
+struct AlertBucket {
+    long long within;
+    const char *label;
+};
+const AlertBucket ALERT_BUCKETS[] = {
+    {12 * 60, "🔴 Due Today"},
+    {2 * 1440, "🟠 Due in 1-2 Days"},
+    {6 * 1440, "🟡 Due in 3-6 Days"},
+};
+
+// Calls f(label, id) for every pending task due from `now` on, soonest first.
+template <class F>
+void forEachAlert(const ToDoList &list, long long now, F f) {
+    MetricTimer timer(METRIC_ALERTS);
+    // Each bucket is the deadline range (previous bucket's end, now + within].
+    const DeadlineIndex &index = list.dueIndex;
+    auto it = index.from(now);
+    for (const auto &bucket : ALERT_BUCKETS) {
+        for (; it != index.byDeadline.end() && it->first <= now + bucket.within; ++it, ++timer.rows)
+            f(bucket.label, it->second);
+    }
+    for (; it != index.byDeadline.end(); ++it, ++timer.rows) f("🟢 Due in 1+ Week", it->second);
+}
+
+
+// ---------- Journal ----------
+
+// An open journal; see openJournal, syncJournal and closeJournal. The
+// fields down to `stop` are shared with the flusher thread under `lock`.
+struct Journal {
+    std::string base;                     // files are base.tbs and base.tbj.<segment>
+    std::mutex lock;
+    std::condition_variable wake;         // records are waiting for the flusher
+    std::condition_variable flushed;      // a batch reached the disk
+    std::string pending;                  // framed records not written yet
+    uint64_t appended = 0;                // records handed to appendJournal
+    uint64_t durable = 0;                 // records written and fsynced
+    bool failed = false;
+    bool stop = false;
+    // Owned by the flusher thread once it runs
+    int fd = -1;
+    uint32_t segment = 0;                 // segment being appended to
+    uint32_t firstSegment = 0;            // oldest segment not in base.tbs yet
+    uint64_t segmentBytes = 0;
+    bool compacting = false;
+    std::thread flusher, compactor;
+    size_t replayed = 0;                  // edits replayed by openJournal
+    std::function<void(const std::string &)> warn;   // problems found later, possibly on another thread
+};
+
+
+// ---------- Undo ----------
+// Each editing action records just enough to reverse itself (the rows it
+// removed, the task before an update, a sort's permutation, ...), so undo
+// costs about as much as the change did instead of a copy of the board.
+
+enum UndoKind {
+    UNDO_ADD_TASK, UNDO_ADD_TASKS, UNDO_UPDATE_TASK, UNDO_REMOVE_ROWS,
+    UNDO_ADD_COLUMN, UNDO_DELETE_COLUMN, UNDO_REORDER, UNDO_REPLACE_LIST
+};
+
+// Which fields are used depends on kind.
+struct UndoStep {
+    UndoKind kind;
+    int nextId = 0;                        // list.nextId before the action
+    std::vector<size_t> rows;              // rows added or removed (ascending), the row updated, or the sort order
+    std::vector<Task> tasks;               // removed tasks, or the task before the update
+    size_t column = 0;                     // column deleted
+    std::string columnName;
+    DataType columnType = DT_STRING;
+    std::vector<Cell> cells;               // deleted column's cells, row by row
+    std::vector<uint8_t> hadCell;          // rows that were long enough to have one
+    std::shared_ptr<ToDoList> previous;    // the whole board a load replaced
+    size_t bytes = 0;                      // approximate, see approxBytes
+};
+
+struct UndoLog {
+    std::deque<UndoStep> steps;
+    size_t bytes = 0;
+    size_t maxSteps = 100;
+    size_t budgetBytes = 256u << 20;  // --undo-mb
+    Journal *journal = nullptr;       // --journal: every edit is also written here
+    std::function<void(const std::string &)> warn;   // told when history had to be dropped
+};
+
+UndoStep makeUndoStep(UndoKind kind, const ToDoList &list);
+
+size_t approxBytes(const Task &t);
+
+size_t approxBytes(const UndoStep &step);
+
+// Adds a step, then forgets the oldest ones past the step or memory limit.
+// A step bigger than the whole budget can't be kept, and older steps can't
+// be replayed without it, so the history is cleared instead.
+void pushUndo(UndoLog &undo, UndoStep step);
+
+
+// ---------- Journal records for edits ----------
+
+// Every edit ends here: journal it (if journaling), then keep its undo step.
+void recordEdit(const ToDoList &list, UndoLog &undo, UndoStep step);
+
+// Moves each Task into its new place exactly once: row i becomes old row order[i].
+void applyRowOrder(ToDoList &list, const std::vector<size_t> &order);
+
+// Takes out the given rows (ascending), keeping them in one undo step.
+void removeRows(ToDoList &list, const std::vector<size_t> &rows, UndoLog &undo);
+
+// Swaps in a freshly loaded board. The old one is moved, not copied, into
+// the undo step, so undoing a load just moves it back.
+void replaceList(ToDoList &list, ToDoList &&next, UndoLog &undo);
+
+bool undoLast(ToDoList &list, UndoLog &undo);
+
+
+// ---------- Editing ----------
+
+// Adds a batch of tasks (ids are handed out here) with one reserve and one
+// index update: small batches go into the indexes row by row, big ones
+// (next to the board) rebuild them, which is cheaper.
+void appendTasks(ToDoList &list, UndoLog &undo, std::vector<Task> &&batch);
+
+// Removes every row with this id; false if there is none.
+bool deleteTaskById(ToDoList &list, UndoLog &undo, int id);
+
+// False if there's no such custom column.
+bool deleteColumnByName(ToDoList &list, UndoLog &undo, const std::string &colName);
+
+// Remove all tasks whose status is "Completed" (case-sensitive match),
+// reading only the status flags column to decide. Returns how many.
+size_t removeCompleted(ToDoList &list, UndoLog &undo);
+
+// Like setCellFromText, except that a value which doesn't fit a typed
+// column is an error instead of being kept as text. Blank always fits.
+bool setTypedCell(Cell &c, DataType type, std::string_view text, std::string &error);
+
+bool updateTaskField(ToDoList &list, UndoLog &undo, int id, const std::string &column, std::string_view value,
+                     std::string &error);
+
+// Adds a custom column holding `value` in every row.
+bool addColumnWithValue(ToDoList &list, UndoLog &undo, const std::string &name, DataType type, std::string_view value,
+                        std::string &error);
+
+// Adds a custom column with cells[r] in row r (one cell per task).
+bool addColumnWithCells(ToDoList &list, UndoLog &undo, const std::string &name, DataType type, std::vector<Cell> cells,
+                        std::string &error);
+
+
+// ---------- CSV files ----------
+
+bool writeCSV(const ToDoList &list, const std::string &path);
+
+struct CSVLoadStats {
+    size_t rows = 0;
+    size_t bytes = 0;
+    size_t skipped = 0;
+    std::vector<std::string> malformedRows;   // rows dropped for a non-numeric ID, as in the file
+    unsigned threads = 1;
+    double seconds = 0;
+};
+
+// Reads a whole CSV board from `in` a line at a time into `fresh`.
+void readCSVStream(ToDoList &fresh, std::istream &in, bool inferTypes, CSVLoadStats &stats);
+
+// One field of a CSV record, pointing straight into the mapped file.
+// Plain fields and fully quoted fields without "" escapes are returned
+// as-is (quotes stripped); anything else keeps its raw text and is only
+// unescaped when it gets copied into a Task or Cell.
+struct CSVField {
+    std::string_view text;
+    bool needsUnescape = false;
+};
+
+// Copies a field into `out`, applying the same quote rules as parseCSVLine.
+void assignCSVField(std::string &out, const CSVField &field);
+
+// Tokenizes one CSV record starting at `p` into `fields` (reusing its
+// storage) and returns a pointer just past the record. Unlike getline +
+// parseCSVLine, a newline inside quotes stays part of the field, so
+// anything csvEscape writes comes back unchanged. A trailing '\r' before
+// the newline is dropped.
+const char *parseCSVRecord(const char *p, const char *end, std::vector<CSVField> &fields);
+
+// Loads `path` through a memory map. Fields are tokenized as string_views
+// into the mapping and copied exactly once, into the Task/Cell that owns
+// them, so there are no per-line strings or per-row token vectors.
+//
+// Large files are split into one byte range per thread (threads = 0 means
+// one per core). A range can start in the middle of a quoted field, so
+// the split happens in two parallel passes:
+//   1. every thread counts the quotes (and newlines) in its range; a
+//      prefix XOR of the quote parities gives the quote state at the
+//      start of each range, exactly as parseCSVLine would have it;
+//   2. every thread moves its start forward to the first newline that is
+//      outside quotes, then parses whole records up to the next range's
+//      start into its own Task batch.
+// The batches are then moved into the list in file order.
+//
+// Extra columns get their types from the file's type row if it has one;
+// otherwise, with `inferTypes`, from the first TYPE_SAMPLE_ROWS records.
+// Values are converted straight from the mapping into native cells.
+bool loadCSVMapped(ToDoList &list, const std::string &path, CSVLoadStats &stats,
+                   bool inferTypes = false, unsigned threads = 0);
+
+
+// ---------- Binary snapshots ----------
+
+// Writes the board as a snapshot image; false if the stream fails.
+bool writeSnapshotTo(const ToDoList &list, std::ostream &out, uint32_t journalSegment = 0);
+
+bool writeSnapshot(const ToDoList &list, const std::string &path, uint32_t journalSegment = 0);
+
+// Loads a snapshot image (8-byte aligned) into `list`, replacing everything
+// in it. On failure `error` says why and `list` is left unusable.
+bool readSnapshotData(ToDoList &list, const char *data, size_t size, std::string &error,
+                      uint32_t *journalSegment = nullptr);
+
+bool readSnapshot(ToDoList &list, const std::string &path, std::string &error, uint32_t *journalSegment = nullptr);
+
+
+// ---------- Journal files ----------
+
+std::string journalSegmentPath(const std::string &base, uint32_t segment);
+
+bool fileExists(const std::string &path);
+
+// Waits until every record appended so far is on disk; false if a write failed.
+bool syncJournal(Journal &journal);
+
+// Loads base.tbs (if any), replays the journal after it into `list` and
+// starts appending. Failures land in `error`, a damaged tail in journal.warn.
+bool openJournal(Journal &journal, ToDoList &list, const std::string &base, std::string &error);
+
+// Writes out anything pending and waits for a running compaction.
+void closeJournal(Journal &journal);
+
+
+// ---------- Sorting ----------
+
+struct SortKey {
+    int column;        // as numbered in the sort menu: 0-4 built in, 5+ custom
+    bool descending;
+};
+
+// The row order for `keys` (most significant first).
+std::vector<size_t> sortedRowOrder(const ToDoList &list, const std::vector<SortKey> &keys, unsigned threads = 0);
+
+// "4,3,-2" -> Status, then Deadline, then Priority descending.
+bool parseSortKeys(const std::string &text, size_t columnCount, std::vector<SortKey> &keys);
+
+// Sort row numbers, then move each Task into its new place exactly once.
+// The row order is also all undo needs.
+void sortRows(ToDoList &list, UndoLog &undo, const std::vector<SortKey> &keys);
+ 
+// One bit per row of a list: a filter's selection. A million rows take
+// 125 KB, so filter history is cheap to keep and to step back through.
+struct RowBitmap {
+    size_t rows = 0;
+    std::vector<uint64_t> words;
+
+    RowBitmap() = default;
+    explicit RowBitmap(size_t n, bool all = false) : rows(n), words((n + 63) / 64, all ? ~0ull : 0) {
+        if (all && n % 64) words.back() = (1ull << (n % 64)) - 1;
+    }
+
+    void set(size_t r) { words[r >> 6] |= 1ull << (r & 63); }
+    bool test(size_t r) const { return (words[r >> 6] >> (r & 63)) & 1; }
+
+    void andWith(const RowBitmap &other) {
+        for (size_t i = 0; i < words.size(); ++i) words[i] &= other.words[i];
+    }
+    void orWith(const RowBitmap &other) {
+        for (size_t i = 0; i < words.size(); ++i) words[i] |= other.words[i];
+    }
+    void andNotWith(const RowBitmap &other) {
+        for (size_t i = 0; i < words.size(); ++i) words[i] &= ~other.words[i];
+    }
+    void clearAll() { std::fill(words.begin(), words.end(), 0); }
+    bool none() const {
+        for (uint64_t w : words)
+            if (w) return false;
+        return true;
+    }
+    size_t count() const {
+        size_t n = 0;
+        for (uint64_t w : words) n += std::bitset<64>(w).count();
+        return n;
+    }
+    // Calls f(row) for each set bit, in row order.
+    template <class F>
+    void forEach(F f) const {
+        for (size_t i = 0; i < words.size(); ++i) {
+            for (uint64_t w = words[i]; w != 0; w &= w - 1) {
+                size_t bit = std::bitset<64>((w & (0 - w)) - 1).count();
+                f(i * 64 + bit);
+            }
+        }
+    }
+};
+
+// Bit r set where column[r] == value. Builds a word (64 rows) at a time
+// with no branches, so code and id filters scan the whole column quickly
+// and are then ANDed with the current selection.
+template <class T>
+RowBitmap matchColumn(const std::vector<T> &column, T value) {
+    RowBitmap out(column.size());
+    for (size_t i = 0; i < out.words.size(); ++i) {
+        size_t base = i * 64, end = std::min(base + 64, column.size());
+        uint64_t bits = 0;
+        for (size_t r = base; r < end; ++r) bits |= uint64_t(column[r] == value) << (r - base);
+        out.words[i] = bits;
+    }
+    return out;
+}
+
+// Does row r of the column store match `value` in custom column `idx`?
+// Typed columns compare native values: the filter value is parsed once
+// (into `wanted`), so "4.5" matches 4.5 and "yes" matches true.
+bool extraCellMatches(const ToDoList &list, const ExtraColumn &col, size_t idx, size_t r,
+                      const Cell &wanted, long long wantedDate, const std::string &value);
+
+
+// ---------- Filter expressions ----------
+// Expressions such as
+//     priority=High AND deadline < 01/08/2026 00:00 AND Hours >= 4
+// are parsed once into a FilterExpr tree, then compiled against the column
+// store into a FilterNode plan: each comparison becomes a typed scan of one
+// column (a range test for numbers, dates and codes, so no per-row parsing
+// or getAsString), AND/OR children run cheapest first, and each child only
+// looks at rows its siblings haven't already decided. Results are bitmaps
+// reused between runs, so re-running a plan allocates nothing.
+
+enum FilterOp { OP_EQ, OP_NE, OP_LT, OP_LE, OP_GT, OP_GE };
+enum ExprKind { EXPR_AND, EXPR_OR, EXPR_NOT, EXPR_COMPARE };
+
+struct FilterExpr {
+    ExprKind kind = EXPR_COMPARE;
+    std::vector<FilterExpr> children;
+    std::string column;   // EXPR_COMPARE
+    FilterOp op = OP_EQ;
+    std::string value;
+};
+
+bool parseFilterExpr(std::string_view src, FilterExpr &out, std::string &error);
+
+enum PlanKind {
+    PLAN_AND, PLAN_OR, PLAN_NOT, PLAN_ALL, PLAN_NONE,
+    PLAN_INT, PLAN_FLOAT, PLAN_MINUTES, PLAN_CODE, PLAN_BYTE, PLAN_TEXT
+};
+
+// A compiled expression. Leaves point into the column store they were
+// compiled against, so a plan is only valid until the list changes.
+struct FilterNode {
+    PlanKind kind = PLAN_NONE;
+    std::vector<FilterNode> children;   // cheapest first
+    int cost = 0;
+
+    // Leaves: rows match when lo <= value <= hi (negated for !=) and the
+    // row has a real value of the column's type.
+    const std::vector<int> *ints = nullptr;
+    const std::vector<float> *floats = nullptr;
+    const std::vector<long long> *minutes = nullptr;   // NO_DEADLINE / LLONG_MAX = no value
+    const std::vector<uint32_t> *codes = nullptr;      // priority or status symbol codes
+    const std::vector<uint8_t> *bytes = nullptr;       // priority ranks or bools
+    const StringColumn *strings = nullptr;
+    const std::vector<uint8_t> *state = nullptr;       // extra columns: CellState per row
+    long long lo = 0, hi = 0;
+    float flo = 0, fhi = 0;
+    bool negate = false;
+    FilterOp op = OP_EQ;                               // PLAN_TEXT
+    std::string text;
+
+    RowBitmap result, rest;   // reused between runs
+};
+
+bool compileFilter(const FilterExpr &e, const ToDoList &list, const ColumnStore &cols, FilterNode &node, std::string &error);
+
+// Fills `out` (sized like `cand`) with the rows of `cand` that match.
+void runFilter(FilterNode &node, const RowBitmap &cand, RowBitmap &out);
+
+
+// ---------- Text search ----------
+// Finds tasks by the words in their name and STRING columns (e.g. the
+// Desc column of Syllabus.csv). Every word of the query has to appear,
+// either whole or inside a longer word ("graph" finds "graphs"); words of
+// one or two letters only match whole. A query word's candidates come
+// from the posting list of its rarest trigram, intersected with its other
+// trigrams', and are then checked against the task's text, so the rarest
+// word decides how much is looked at instead of the size of the board.
+//
+// Ranking adds up, per query word, how rare it is across the board times
+// where it was found: a whole word in the name counts most, then part of
+// a word in the name, then a whole word elsewhere, then part of one.
+
+struct SearchHit {
+    int id;
+    size_t row;
+    double score;
+};
+
+// Builds the list's text index and keeps it up to date from then on.
+void enableTextIndex(ToDoList &list);
+
+// The `limit` best matches for `query`, best first (ties by id). Without
+// the text index every task is checked and rare words count no extra.
+std::vector<SearchHit> searchTasks(const ToDoList &list, std::string_view query, size_t limit);
+
+
+// ---------- Shared boards ----------
+// A board shared between threads, e.g. a service whose dashboards query
+// schedules and alerts while edits keep coming in. Readers take the
+// current BoardVersion, an immutable board they can query for as long as
+// they hold it, and never wait for a writer. Writers take turns: each
+// edit runs on a spare copy of the board, which then becomes the current
+// version. Spare copies catch up by replaying the edits they missed
+// instead of copying the board, so an edit costs what it costs on a plain
+// ToDoList once per copy.
+
+// One edit. It runs once per copy, so it must do the same thing every
+// time: copy captured data in rather than moving it out.
+typedef std::function<void(ToDoList &, UndoLog &)> BoardEdit;
+
+struct BoardVersion {
+    uint64_t number = 0;   // counts edits (and resets) so far
+    ToDoList list;
+    UndoLog undo;          // this copy's history, for undoLast inside an edit
+};
+
+struct TaskBoard {
+    // Only through atomic_load / atomic_store (readBoard, editBoard)
+    std::shared_ptr<BoardVersion> current = std::make_shared<BoardVersion>();
+    size_t maxCopies = 3;          // memory vs. how long readers may keep old versions
+    Journal *journal = nullptr;    // sees each edit once, as UndoLog::journal
+    std::function<void(const std::string &)> warn;   // UndoLog::warn, also once per edit
+
+    // Writers only, under writeLock
+    std::mutex writeLock;
+    std::vector<std::shared_ptr<BoardVersion>> copies;   // current included
+    std::deque<BoardEdit> edits;   // edits[i] turns version firstEdit + i into the next one
+    uint64_t firstEdit = 0;
+};
+
+// Makes `list` the board's next version and forgets the edit history.
+void resetBoard(TaskBoard &board, ToDoList &&list);
+
+// The current version; never waits.
+std::shared_ptr<const BoardVersion> readBoard(const TaskBoard &board);
+
+// Runs `edit`, publishes the result and returns its version number. Waits
+// for other writers, and when every spare copy is still held by readers
+// and maxCopies are in use, for one of them to let go.
+uint64_t editBoard(TaskBoard &board, BoardEdit edit);
+
+
+// ---------- Workspaces ----------
+// Many boards, e.g. one per team, kept in one directory as <name>.tbs
+// snapshots or <name>.csv files. A board is read the first time it's
+// used; when the loaded boards together pass the memory budget, the least
+// recently used ones are written back as snapshots (if they changed) and
+// unloaded, undo history and all. Every board belongs to one worker
+// thread, picked from its name, and everything done to a board runs
+// there: boards need no locks, and boards on different workers are
+// worked on in parallel. A query across boards runs on every worker at
+// once and the results are merged.
+
+// A board as its worker sees it.
+struct WorkspaceBoard {
+    std::string name;
+    std::string path;          // where it's read from; empty for a new board
+    unsigned worker = 0;
+
+    // Its worker only
+    ToDoList list;
+    UndoLog undo;
+    std::string error;         // why it couldn't be read; it's then empty and never saved
+    size_t savedVersion = 0;   // list.version when it last matched its file
+    size_t bytesPerTask = 0;   // estimated when it was read
+
+    // Under Workspace::lock
+    bool loaded = false;
+    bool evicting = false;
+    size_t bytes = 0;          // estimated, undo history included
+    uint64_t lastUse = 0;
+};
+
+// Runs on the board's worker, so it must not wait for other workspace
+// work, which may be queued behind it. It must not throw.
+typedef std::function<void(WorkspaceBoard &)> BoardJob;
+
+struct WorkspaceWorker {
+    std::thread thread;
+    std::mutex lock;
+    std::condition_variable wake;
+    std::deque<std::function<void()>> jobs;
+    bool stop = false;
+};
+
+struct Workspace;
+
+void closeWorkspace(Workspace &ws);
+
+struct Workspace {
+    std::string directory;
+    size_t budgetBytes = 1024u << 20;      // loaded boards, estimated
+    size_t undoBudgetBytes = 16u << 20;    // each board's UndoLog::budgetBytes
+    std::function<void(const std::string &)> warn;   // boards that couldn't be read or saved; called by workers
+
+    std::mutex lock;
+    std::map<std::string, std::unique_ptr<WorkspaceBoard>> boards;   // never shrinks while open
+    size_t usedBytes = 0;
+    uint64_t clock = 0;                    // ticks once per job, for lastUse
+    size_t loads = 0, evictions = 0;
+
+    std::vector<std::unique_ptr<WorkspaceWorker>> workers;
+
+    ~Workspace() { closeWorkspace(*this); }
+};
+
+// Letters, digits, '-', '_' and '.' (not first), at most 64: safe as a file name.
+bool validBoardName(std::string_view name);
+
+// Registers every board file in `directory` (created if missing; when a
+// board has both a .tbs and a .csv, the newer one) and starts `workers`
+// threads, 0 meaning one per core. Nothing is read yet.
+bool openWorkspace(Workspace &ws, const std::string &directory, unsigned workers, std::string &error);
+
+// Finishes the queued work, writes back every changed board and stops
+// the workers.
+void closeWorkspace(Workspace &ws);
+
+// Queues `job` on the board's worker, reading the board first if it isn't
+// loaded; a name with no board gets a new, empty one. Jobs on one board
+// run in the order they were queued. False (and the job is dropped) if
+// the name isn't valid or the workspace isn't open.
+bool postToBoard(Workspace &ws, const std::string &name, BoardJob job);
+
+// postToBoard with the job's result in a future.
+template <class F>
+auto withBoard(Workspace &ws, const std::string &name, F job) -> std::future<decltype(job(std::declval<WorkspaceBoard &>()))> {
+    typedef decltype(job(std::declval<WorkspaceBoard &>())) Result;
+    auto task = std::make_shared<std::packaged_task<Result(WorkspaceBoard &)>>(std::move(job));
+    std::future<Result> result = task->get_future();
+    postToBoard(ws, name, [task](WorkspaceBoard &board) { (*task)(board); });
+    return result;
+}
+
+struct WorkspaceStats {
+    size_t boards = 0, loaded = 0, usedBytes = 0, loads = 0, evictions = 0;
+};
+
+WorkspaceStats workspaceStats(Workspace &ws);
+
+// A task found by a query across boards.
+struct WorkspaceMatch {
+    std::string board;
+    int id = 0;
+    std::string name, priority, deadline, status;
+    long long deadlineMinutes = NO_DEADLINE;
+};
+
+// Up to `limit` tasks of `list` matching `expr`, soonest deadline first.
+// Nothing matches on a board the expression doesn't compile against,
+// e.g. one without a column it names.
+std::vector<WorkspaceMatch> matchTasks(const ToDoList &list, const std::string &board, const FilterExpr &expr, size_t limit);
+
+// Soonest deadline first (then board, then id), at most `limit`.
+void mergeMatches(std::vector<WorkspaceMatch> &matches, size_t limit);
+
+typedef std::function<void(std::vector<WorkspaceMatch> &&, const std::string &error)> WorkspaceQueryDone;
+
+// Runs a filter expression on every board at once and hands the merged
+// matches to `done`, on whichever worker finishes last (or right away on
+// this thread if the expression doesn't parse).
+void queryWorkspaceAsync(Workspace &ws, const std::string &expression, size_t limit, WorkspaceQueryDone done);
+
+// The same, waiting for the result. Not from inside a BoardJob.
+bool queryWorkspace(Workspace &ws, const std::string &expression, size_t limit, std::vector<WorkspaceMatch> &out,
+                    std::string &error);
+
+#endif
@@ -7,49 +7,57 @@
 #include <sstream>
 #include <iomanip>
 #include <fstream>
-#include <queue>
 #include <map>
 #include <clocale>
+#include <cstring>
+#include <charconv>
+#include <chrono>
+#include <thread>
+#ifdef _WIN32
 #include <windows.h>
+#else
+#include <csignal>
+#include <cerrno>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#endif
+#include "TaskBoard.h"
 using namespace std;
 
-enum DataType { DT_INT, DT_STRING, DT_BOOL, DT_FLOAT, DT_DATE, DT_LINK};
-
-struct Cell {
-    DataType type;
-    string stringValue;
-    int intValue;
-    bool boolValue;
-    float floatValue;
-    string dateValue;
-
-    void setValue(string val) { type = DT_STRING; stringValue = val; }
-    void setValue(int val) { type = DT_INT; intValue = val; }
-    void setValue(bool val) { type = DT_BOOL; boolValue = val; }
-    void setValue(float val) { type = DT_FLOAT; floatValue = val; }
-    void setDate(string val) { type = DT_DATE; dateValue = val; }
-
-    string getAsString() const {
-        switch (type) {
-            case DT_INT: return to_string(intValue);
-            case DT_STRING: return stringValue;
-            case DT_BOOL: return boolValue ? "Yes" : "No";
-            case DT_FLOAT: return to_string(floatValue);
-            case DT_DATE: return dateValue;
-            case DT_LINK: return stringValue;
-        }
-        return "";
-    }
-};
 
-struct Task {
-    int id;
-    string name;
-    string priority;
-    string deadline;
-    string status;
-    vector<Cell> extraColumns;
-};
+// ---------- Allocation counting ----------
+
+// Counts every heap allocation for the instrumentation in TaskBoard.h. Worker
+// threads' allocations show up in the program totals only.
+void *operator new(size_t size) {
+    ++threadAllocs;
+    threadAllocBytes += size;
+    totalAllocs.fetch_add(1, memory_order_relaxed);
+    totalAllocBytes.fetch_add(size, memory_order_relaxed);
+    if (void *p = malloc(size ? size : 1)) return p;
+    throw bad_alloc();
+}
+// GCC 12 misreads malloc/free inside replaced operators as a mismatch
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpragmas"
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+
+// ---------- Console input ----------
 
 // Reads a yes/no (or true/false, 1/0) answer safely.
 // Unlike `cin >> boolValue`, this never leaves cin in a fail state,
@@ -66,156 +74,118 @@ bool readBoolInput() {
     }
 }
 
-// Splits one CSV line into fields, respecting double-quoted fields
-// that may contain commas or escaped quotes ("").
-vector<string> parseCSVLine(const string &line) {
-    vector<string> tokens;
-    string current;
-    bool inQuotes = false;
-    for (size_t i = 0; i < line.size(); ++i) {
-        char c = line[i];
-        if (inQuotes) {
-            if (c == '"') {
-                if (i + 1 < line.size() && line[i + 1] == '"') {
-                    current += '"';
-                    ++i;
-                } else {
-                    inQuotes = false;
-                }
-            } else {
-                current += c;
-            }
-        } else {
-            if (c == '"') {
-                inQuotes = true;
-            } else if (c == ',') {
-                tokens.push_back(current);
-                current.clear();
-            } else {
-                current += c;
-            }
-        }
-    }
-    tokens.push_back(current);
-    return tokens;
+void readDeadlineInput(Task &t) {
+    string input;
+    while (getline(cin, input) && !setDeadline(t, input))
+        cout << "Invalid deadline. Please use dd/mm/yyyy hh:mm (e.g. 5/3/2025 9:30): ";
 }
 
-// Wraps a field in quotes (escaping internal quotes) if it contains
-// a comma, quote, or newline, so CSV export/import round-trips safely.
-string csvEscape(const string &field) {
-    bool needsQuotes = field.find(',') != string::npos ||
-                        field.find('"') != string::npos ||
-                        field.find('\n') != string::npos;
-    if (!needsQuotes) return field;
-    string escaped = "\"";
-    for (char c : field) {
-        if (c == '"') escaped += "\"\"";
-        else escaped += c;
-    }
-    escaped += "\"";
-    return escaped;
-}
 
-int getPriorityValue(const string& p) {
-    if (p == "High") return 3;
-    if (p == "Medium") return 2;
-    if (p == "Low") return 1;
-    return 0;
-}
+// ---------- Alerts ----------
 
-// Forward declaration: CompareTasks needs this for proper date-based
-// tie-breaking (defined further down, after the Task/ToDoList structs).
-time_t parseDeadline(const string& deadline);
+void printAlertLine(const ToDoList &list, const char *label, int id) {
+    size_t row = findRow(list, id);
+    if (row == NO_ROW) return;
+    const Task &task = list.tasks[row];
+    cout << label << ":    Task #" << task.id << " - \"" << task.name << "\""
+         << " | Deadline: " << task.deadline << endl;
+}
 
-struct CompareTasks {
-    bool operator()(const Task& a, const Task& b) {
-        time_t da = parseDeadline(a.deadline);
-        time_t db = parseDeadline(b.deadline);
+void showCategorizedAlerts(const ToDoList &list) {
+    bool found = false;
 
-        // Primary: earlier deadline goes first.
-        if (da != db)
-            return da > db;
+    cout << "\n===== Task Alerts (by Due Date) =====\n";
+    forEachAlert(list, nowWallMinutes(), [&](const char *label, int id) {
+        printAlertLine(list, label, id);
+        found = true;
+    });
 
-        // Tiebreak: only kicks in when deadlines match exactly —
-        // then higher priority (High > Medium > Low) goes first.
-        return getPriorityValue(a.priority) < getPriorityValue(b.priority);
+    if (!found) {
+        cout << "No upcoming tasks within a week.\n";
     }
-};
+}
 
 
-struct ToDoList {
-    string name;
-    vector<string> columnNames;
-    vector<DataType> columnTypes;
-    vector<Task> tasks;
-    int nextId = 1;
-};
+// ---------- Background alerts ----------
+// A worker thread that sleeps until the next time some task crosses into
+// a tighter bucket (or reaches its deadline) and prints just those tasks.
+// The main loop holds `lock` while it runs a menu action, so the worker
+// only ever reads the list between actions.
 
-time_t parseDeadline(const string& deadline) {
-    istringstream ss(deadline);
-    int year, month, day, hour, minute;
-    char sep1, sep2, space, sep3;
+struct AlertEngine {
+    mutex lock;
+    condition_variable wake;   // notified after every menu action
+    thread worker;
+    bool stop = false;
+};
 
-    // Note: reading the space with `>>` would skip whitespace and eat the
-    // first digit of the hour instead (breaking any hour >= 10). `.get()`
-    // reads the literal next character, so it consumes just the space.
-    ss >> day >> sep1 >> month >> sep2 >> year;
-    ss.get(space);
-    ss >> hour >> sep3 >> minute;
+// Every boundary a task can cross: into each bucket, then the deadline.
+const AlertBucket ALERT_BOUNDARIES[] = {
+    ALERT_BUCKETS[0], ALERT_BUCKETS[1], ALERT_BUCKETS[2],
+    {0, "⏰ Deadline reached"},
+};
 
-    if (ss.fail()) {
-        cerr << "Failed to parse deadline: " << deadline << endl;
-        return time(0) + 999999;  //Pushed the task far in future so it avoids alert
+// The first minute after `now` at which any task crosses a boundary, or
+// NO_DEADLINE. One lookup per boundary, O(log n).
+long long nextAlertMinute(const DeadlineIndex &index, long long now) {
+    long long next = NO_DEADLINE;
+    for (const auto &b : ALERT_BOUNDARIES) {
+        auto it = index.from(now + b.within + 1);
+        if (it != index.byDeadline.end()) next = min(next, it->first - b.within);
     }
-
-    tm timeStruct = {};
-    timeStruct.tm_mday = day;
-    timeStruct.tm_mon = month - 1;
-    timeStruct.tm_year = year - 1900;
-    timeStruct.tm_hour = hour;
-    timeStruct.tm_min = minute;
-    timeStruct.tm_sec = 0;
-
-    return mktime(&timeStruct);
+    return next;
 }
 
-
-void showCategorizedAlerts(const ToDoList &list) {
-    time_t now = time(0);
-    bool found = false;
-
-    cout << "\n===== Task Alerts (by Due Date) =====\n";
-
-    for (const auto& task : list.tasks) {
-        time_t taskTime = parseDeadline(task.deadline);
-        double daysLeft = difftime(taskTime, now) / (60.0 * 60.0 * 24.0);
-
-        if (daysLeft < 0) continue;
-
-        string category;
-
-        if (daysLeft <= 0.5) {
-            category = "🔴 Due Today";
-        } else if (daysLeft <= 2) {
-            category = "🟠 Due in 1-2 Days";
-        } else if (daysLeft <= 6) {
-            category = "🟡 Due in 3-6 Days";
-        } else {
-            category = "🟢 Due in 1+ Week";
+// Prints tasks that crossed a boundary in (from, to]; for each boundary
+// that's the deadline range (from + within, to + within].
+void announceCrossings(const ToDoList &list, long long from, long long to) {
+    const DeadlineIndex &index = list.dueIndex;
+    bool any = false;
+    for (const auto &b : ALERT_BOUNDARIES) {
+        for (auto it = index.from(from + b.within + 1); it != index.byDeadline.end() && it->first <= to + b.within; ++it) {
+            if (!any) cout << "\n🔔 Alert\n";
+            any = true;
+            printAlertLine(list, b.label, it->second);
         }
+    }
+}
 
-        cout << category << ":    Task #" << task.id << " - \"" << task.name << "\""
-             << " | Deadline: " << task.deadline << endl;
-
-        found = true;
+void alertLoop(AlertEngine &engine, const ToDoList &list) {
+    unique_lock<mutex> guard(engine.lock);
+    long long checked = nowWallMinutes();
+    while (!engine.stop) {
+        long long now = nowWallMinutes();
+        if (now > checked) {
+            announceCrossings(list, checked, now);
+            checked = now;
+        }
+        long long next = nextAlertMinute(list.dueIndex, now);
+        // Wake at the start of that minute, but at least hourly in case
+        // the clock jumps.
+        long long seconds = next == NO_DEADLINE ? 3600 : (next - now) * 60 - time(0) % 60;
+        engine.wake.wait_for(guard, chrono::seconds(max(1LL, min(seconds, 3600LL))));
     }
+}
 
-    if (!found) {
-        cout << "No upcoming tasks within a week.\n";
+void startAlerts(AlertEngine &engine, const ToDoList &list) {
+    engine.stop = false;
+    engine.worker = thread(alertLoop, ref(engine), cref(list));
+}
+
+// Call without holding engine.lock.
+void stopAlerts(AlertEngine &engine) {
+    if (!engine.worker.joinable()) return;
+    {
+        lock_guard<mutex> guard(engine.lock);
+        engine.stop = true;
     }
+    engine.wake.notify_one();
+    engine.worker.join();
 }
 
 
+// ---------- Menu ----------
+
 void displayMenu() {
     cout << "\n====== TASK MANAGER MENU ======\n";
     cout << "1. Add Column\n";
@@ -234,111 +204,306 @@ void displayMenu() {
     cout << "14. Remove completed tasks\n";
     cout << "15. View full cell\n";
     cout << "16. Undo last action\n";
+    cout << "17. Fast Load from CSV (memory-mapped)\n";
+    cout << "18. Toggle background alerts\n";
+    cout << "19. Save snapshot (binary .tbs)\n";
+    cout << "20. Open snapshot (binary .tbs)\n";
+    cout << "21. Search tasks\n";
     cout << "0. Exit\n\n";
 }
 
-void addColumn(ToDoList &list) {
-    string name;
-    int type;
+// Reads one value of `dtype` from the console.
+Cell readCellInput(DataType dtype) {
+    Cell c;
+    string text;
+    switch (dtype) {
+        case DT_INT: { int v = 0; cin >> v; cin.ignore(); c.setValue(v); break; }
+        case DT_BOOL: c.setValue(readBoolInput()); break;
+        case DT_FLOAT: { float v = 0; cin >> v; cin.ignore(); c.setValue(v); break; }
+        case DT_DATE: getline(cin, text); c.setDate(text); break;
+        case DT_LINK: getline(cin, text); c.setLink(text); break;
+        default: getline(cin, text); c.setValue(text); break;
+    }
+    return c;
+}
+
+void addColumn(ToDoList &list, UndoLog &undo) {
+    string name, error;
+    int type = 0;
     cout << "Enter column name: ";
     getline(cin, name);
-    cout << "Data Type (1-INT, 2-STRING, 3-BOOL, 4-FLOAT): ";
-    cin >> type;
-    cin.ignore();
+    if (name.empty() || findColumn(list, name) >= 0) {
+        cout << "❌ " << (name.empty() ? "Column name can't be empty." : "Column '" + name + "' already exists.") << "\n";
+        return;
+    }
+    cout << "Data Type (1-INT, 2-STRING, 3-BOOL, 4-FLOAT, 5-DATE, 6-LINK): ";
+    if (!(cin >> type)) cin.clear();
+    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+    if (type < 1 || type > DT_LINK + 1) {
+        cout << "❌ Invalid data type.\n";
+        return;
+    }
     DataType dtype = static_cast<DataType>(type - 1);
-    list.columnNames.push_back(name);
-    list.columnTypes.push_back(dtype);
 
+    vector<Cell> cells;
+    cells.reserve(list.tasks.size());
     for (auto &task : list.tasks) {
-        Cell c; c.type = dtype;
         cout << "Enter value for Task ID " << task.id << ": ";
-        switch (dtype) {
-            case DT_INT: cin >> c.intValue; cin.ignore(); break;
-            case DT_STRING: getline(cin, c.stringValue); break;
-            case DT_BOOL: c.boolValue = readBoolInput(); break;
-            case DT_FLOAT: cin >> c.floatValue; cin.ignore(); break;
-            default: getline(cin, c.stringValue); break;
-        }
-        task.extraColumns.push_back(c);
+        cells.push_back(readCellInput(dtype));
     }
+    if (addColumnWithCells(list, undo, name, dtype, move(cells), error)) cout << "✅ Column '" << name << "' added.\n";
+    else cout << "❌ " << error << "\n";
 }
 
-void addTask(ToDoList &list) {
+void addTask(ToDoList &list, UndoLog &undo) {
     Task t;
-    t.id = list.nextId++;
-
     cout << "Enter Task Name: ";
     getline(cin, t.name);
     cout << "Priority (High/Medium/Low): ";
-    getline(cin, t.priority);
+    string priority;
+    getline(cin, priority);
+    t.priority = list.priorities.intern(priority);
     cout << "Deadline (dd/mm/yyyy hh:mm): ";
-    getline(cin, t.deadline);
-    t.status = "Pending";
+    readDeadlineInput(t);
+    t.status = STATUS_PENDING;
 
     for (size_t i = 0; i < list.columnTypes.size(); ++i) {
         DataType dtype = list.columnTypes[i];
         string colName = list.columnNames[i];
-        Cell c;
-        c.type = dtype;
 
         cout << "Enter value for '" << colName << "': ";
-        switch (dtype) {
-            case DT_INT: cin >> c.intValue; cin.ignore(); break;
-            case DT_BOOL: c.boolValue = readBoolInput(); break;
-            case DT_FLOAT: cin >> c.floatValue; cin.ignore(); break;
-            case DT_STRING: getline(cin, c.stringValue); break;
-            case DT_DATE: getline(cin, c.dateValue); break;
-            default: getline(cin, c.stringValue); break;
-        }
-
-        t.extraColumns.push_back(c);
+        t.extraColumns.push_back(readCellInput(dtype));
     }
 
-
-    list.tasks.push_back(t);
+    // The same path as a batch add: ids, indexes, undo and metrics
+    vector<Task> one;
+    one.push_back(move(t));
+    appendTasks(list, undo, move(one));
     cout << "✅ Task added successfully.\n";
 }
 
-string fitToWidth(const string &str, int width) {         //Replaces the column values with '...' if the value exceeds the column width
-    if ((int)str.length() <= width)
-        return str + string(width - str.length(), ' ');
-    else if (width >= 4)
-        return str.substr(0, width - 3) + "...";
-    else
-        return str.substr(0, width);
+
+// ---------- Table printing ----------
+// printToDoList and the filter menu both go through TablePrinter: a page
+// of rows is formatted straight into one buffer (numbers with to_chars,
+// text as string_views, no per-cell strings) and written out with a single
+// write. Widths are display columns, not bytes, so emoji and accented
+// text line up.
+
+const size_t PAGE_ROWS = 50;
+
+// Terminal columns taken by code point c: 0 for combining marks and
+// variation selectors, 2 for wide (CJK) characters and emoji.
+int codePointWidth(uint32_t c) {
+    static const uint32_t zero[][2] = {
+        {0x0300, 0x036F}, {0x200B, 0x200F}, {0x20D0, 0x20FF}, {0xFE00, 0xFE0F},
+        {0xFE20, 0xFE2F}, {0x1F3FB, 0x1F3FF}, {0xE0100, 0xE01EF}};
+    static const uint32_t wide[][2] = {
+        {0x1100, 0x115F}, {0x231A, 0x231B}, {0x23E9, 0x23EC}, {0x23F0, 0x23F0}, {0x23F3, 0x23F3},
+        {0x25FD, 0x25FE}, {0x2614, 0x2615}, {0x2648, 0x2653}, {0x267F, 0x267F}, {0x2693, 0x2693},
+        {0x26A1, 0x26A1}, {0x26AA, 0x26AB}, {0x26BD, 0x26BE}, {0x26C4, 0x26C5}, {0x26CE, 0x26CE},
+        {0x26D4, 0x26D4}, {0x26EA, 0x26EA}, {0x26F2, 0x26F3}, {0x26F5, 0x26F5}, {0x26FA, 0x26FA},
+        {0x26FD, 0x26FD}, {0x2705, 0x2705}, {0x270A, 0x270B}, {0x2728, 0x2728}, {0x274C, 0x274C},
+        {0x274E, 0x274E}, {0x2753, 0x2755}, {0x2757, 0x2757}, {0x2795, 0x2797}, {0x27B0, 0x27B0},
+        {0x27BF, 0x27BF}, {0x2B1B, 0x2B1C}, {0x2B50, 0x2B50}, {0x2B55, 0x2B55}, {0x2E80, 0x303E},
+        {0x3041, 0x33FF}, {0x3400, 0x4DBF}, {0x4E00, 0x9FFF}, {0xA000, 0xA4CF}, {0xAC00, 0xD7A3},
+        {0xF900, 0xFAFF}, {0xFE30, 0xFE4F}, {0xFF00, 0xFF60}, {0xFFE0, 0xFFE6}, {0x1F300, 0x1F64F},
+        {0x1F680, 0x1F6FF}, {0x1F900, 0x1F9FF}, {0x1FA70, 0x1FAFF}, {0x20000, 0x3FFFD}};
+    if (c < 0x300) return c >= 0x20 && c != 0x7F ? 1 : 0;
+    for (const auto &r : zero)
+        if (c >= r[0] && c <= r[1]) return 0;
+    for (const auto &r : wide)
+        if (c >= r[0] && c <= r[1]) return 2;
+    return 1;
 }
 
-void printToDoList(const ToDoList &list) {           
-    cout << "\n=== " << list.name << " ===\n";
-    cout << left << setw(5) << "ID" << setw(20) << "Task Name"
-         << setw(10) << "Priority" << setw(20) << "Deadline"
-         << setw(15) << "Status";
+// Decodes the code point at s[i] and moves i past it. Bytes that aren't
+// valid UTF-8 come back one at a time as themselves.
+uint32_t nextCodePoint(string_view s, size_t &i) {
+    unsigned char b = s[i];
+    int extra = b >= 0xF0 ? 3 : b >= 0xE0 ? 2 : b >= 0xC0 ? 1 : 0;
+    if (extra == 0 || i + extra >= s.size()) {
+        ++i;
+        return b;
+    }
+    uint32_t c = b & (0x3F >> extra);
+    for (int k = 1; k <= extra; ++k) {
+        unsigned char cont = s[i + k];
+        if ((cont & 0xC0) != 0x80) {
+            ++i;
+            return b;
+        }
+        c = (c << 6) | (cont & 0x3F);
+    }
+    i += extra + 1;
+    return c;
+}
 
-    for (const auto &col : list.columnNames)
-        cout << setw(25) << col;
-    cout << "\n";
+// Display width of the longest prefix of s that fits in `limit` columns;
+// `bytes` is that prefix's length. An emoji presentation selector (as in
+// "⚠️") widens the character before it, and whatever follows a zero-width
+// joiner is drawn as part of the same emoji.
+size_t displayPrefix(string_view s, size_t limit, size_t &bytes) {
+    size_t width = 0, i = 0;
+    int last = 0;
+    bool joined = false;
+    bytes = 0;
+    while (i < s.size()) {
+        uint32_t c = nextCodePoint(s, i);
+        int w = joined ? 0 : codePointWidth(c);
+        if (c == 0xFE0F && last == 1) w = 1;
+        joined = c == 0x200D;
+        if (width + w > limit) break;
+        width += w;
+        if (w > 0) last = w;
+        bytes = i;
+    }
+    return width;
+}
 
-    int totalWidth = 5 + 20 + 10 + 20 + 15 + (25 * list.columnNames.size());
-    cout << string(totalWidth, '-') << "\n";
+size_t displayWidth(string_view s) {
+    size_t bytes;
+    return displayPrefix(s, SIZE_MAX, bytes);
+}
 
-    for (const auto &task : list.tasks) {
-        cout << left
-            << setw(5) << task.id
-            << setw(20) << fitToWidth(task.name, 20)
-            << setw(10) << fitToWidth(task.priority, 10)
-            << setw(20) << fitToWidth(task.deadline, 20)
-            << setw(15) << fitToWidth(task.status, 15);
+struct TablePrinter {
+    string out;              // kept between pages, so its capacity is reused
+    size_t extraWidth;       // custom column field width
+    size_t extraFit;         // and how much of it a value may use
 
-        for (const auto &cell : task.extraColumns)
-            cout << setw(25) << fitToWidth(cell.getAsString(), 20);
+    TablePrinter(size_t width, size_t fit) : extraWidth(width), extraFit(fit) {}
 
-        cout << "\n";
+    void pad(size_t used, size_t width) {
+        if (used < width) out.append(width - used, ' ');
     }
-}
+    // Text cut to `fit` columns ("..." marks a cut), then padded to `width`.
+    // Control characters (a stray '\r', say) would break the row, so they
+    // are left out.
+    void text(string_view s, size_t fit, size_t width) {
+        bool plain = true;   // printable ASCII: one column per byte
+        for (unsigned char ch : s)
+            if (ch < 0x20 || ch >= 0x7F) {
+                plain = false;
+                break;
+            }
+        if (plain) {
+            size_t keep = s.size() <= fit ? s.size() : fit >= 4 ? fit - 3 : fit;
+            out.append(s.data(), keep);
+            if (keep < s.size() && fit >= 4) out += "...";
+            return pad(keep < s.size() && fit >= 4 ? fit : keep, width);
+        }
+        size_t bytes, used = displayPrefix(s, fit, bytes);
+        if (bytes < s.size() && fit >= 4) used = displayPrefix(s, fit - 3, bytes);
+        for (size_t i = 0; i < bytes;) {
+            size_t run = i;
+            while (run < bytes && (unsigned char)s[run] >= 0x20 && s[run] != 0x7F) ++run;
+            out.append(s.data() + i, run - i);
+            i = run < bytes ? run + 1 : run;
+        }
+        if (bytes < s.size() && fit >= 4) {
+            out += "...";
+            used += 3;
+        }
+        pad(used, width);
+    }
+    void number(long long v, size_t width) {
+        char buf[24];
+        auto end = to_chars(buf, buf + sizeof(buf), v).ptr;
+        out.append(buf, end);
+        pad(end - buf, width);
+    }
+    void cell(const Cell &c) {
+        char buf[64];
+        char *end = buf;
+        long long minutes;
+        switch (c.type()) {
+            case DT_INT: end = to_chars(buf, buf + sizeof(buf), c.getInt()).ptr; break;
+            case DT_BOOL: return text(c.getBool() ? "Yes" : "No", extraFit, extraWidth);
+            case DT_FLOAT:   // same digits as to_string
+                end = to_chars(buf, buf + sizeof(buf), (double)c.getFloat(), chars_format::fixed, 6).ptr;
+                break;
+            case DT_DATE:
+                if (!c.getText().empty() || !c.getDateMinutes(minutes)) return text(c.getText(), extraFit, extraWidth);
+                end = buf + formatDateTimeTo(buf, sizeof(buf), minutes);
+                break;
+            default: return text(c.getText(), extraFit, extraWidth);
+        }
+        text(string_view(buf, end - buf), extraFit, extraWidth);
+    }
+
+    void header(const ToDoList &list) {
+        text("ID", 5, 5);
+        text("Task Name", 20, 20);
+        text("Priority", 10, 10);
+        text("Deadline", 20, 20);
+        text("Status", 15, 15);
+        for (const auto &col : list.columnNames) text(col, extraFit, extraWidth);
+        out += '\n';
+        out.append(5 + 20 + 10 + 20 + 15 + extraWidth * list.columnNames.size(), '-');
+        out += '\n';
+    }
+    void row(const ToDoList &list, const Task &task) {
+        number(task.id, 5);
+        text(task.name, 20, 20);
+        text(list.priorities.text(task.priority), 10, 10);
+        text(task.deadline, 20, 20);
+        text(list.statuses.text(task.status), 15, 15);
+        for (const auto &c : task.extraColumns) cell(c);
+        out += '\n';
+    }
+    // Rows first..first+count of `rows` (every row if null), in one write.
+    void print(const ToDoList &list, const vector<size_t> *rows, size_t first, size_t count) {
+        out.clear();
+        size_t total = rows != nullptr ? rows->size() : list.tasks.size();
+        size_t lineBytes = 5 + 20 + 10 + 20 + 15 + extraWidth * list.columnNames.size() + 1;
+        out.reserve(lineBytes * (min(count, total - min(first, total)) + 2));
+        header(list);
+        MetricTimer timer(METRIC_PRINT);
+        for (size_t i = first; i < total && i < first + count; ++i, ++timer.rows)
+            row(list, list.tasks[rows != nullptr ? (*rows)[i] : i]);
+        timer.bytesOut = out.size();
+        cout.flush();
+        fwrite(out.data(), 1, out.size(), stdout);
+        fflush(stdout);
+    }
+};
 
+// Shows `rows` (every row if null) a page at a time. Small tables print
+// in full with no prompt.
+void showTable(const ToDoList &list, const vector<size_t> *rows, TablePrinter &printer) {
+    size_t total = rows != nullptr ? rows->size() : list.tasks.size();
+    size_t first = 0;
+    while (true) {
+        printer.print(list, rows, first, PAGE_ROWS);
+        size_t last = min(total, first + PAGE_ROWS);
+        if (first == 0 && last == total) return;
+        cout << "Rows " << first + 1 << "-" << last << " of " << total
+             << ". Enter = next page, b = back, a = all the rest, a row number = jump there, q = done: ";
+        string input;
+        if (!getline(cin, input) || input == "q") return;
+        if (input.empty()) {
+            if (last == total) return;
+            first = last;
+        } else if (input == "b") {
+            first = first >= PAGE_ROWS ? first - PAGE_ROWS : 0;
+        } else if (input == "a") {
+            if (last < total) printer.print(list, rows, last, total - last);
+            return;
+        } else {
+            size_t to = 0;
+            auto res = from_chars(input.data(), input.data() + input.size(), to);
+            if (res.ec == errc() && to > 0) first = min(to, total) - 1;
+        }
+    }
+}
 
+void printToDoList(const ToDoList &list) {
+    cout << "\n=== " << list.name << " ===\n";
+    static TablePrinter printer(25, 20);
+    showTable(list, nullptr, printer);
+}
 
-void updateCell(ToDoList &list) {
+void updateCell(ToDoList &list, UndoLog &undo) {
     int id;
     string colName;
     cout << "Enter Task ID: ";
@@ -347,111 +512,68 @@ void updateCell(ToDoList &list) {
     cout << "Enter Column Name (e.g. TaskName, Priority, Deadline, Status or your custom column): ";
     getline(cin, colName);
 
-    for (auto &task : list.tasks) {
-        if (task.id == id) {
-            if (colName == "TaskName") {
-                cout << "New Task Name: ";
-                getline(cin, task.name);
-            } else if (colName == "Priority") {
-                cout << "New Priority: ";
-                getline(cin, task.priority);
-            } else if (colName == "Deadline") {
-                cout << "New Deadline: ";
-                getline(cin, task.deadline);
-            } else if (colName == "Status") {
-                cout << "New Status: ";
-                getline(cin, task.status);
-            } else {
-                // Search in extra columns
-                bool found = false;
-                for (size_t i = 0; i < list.columnNames.size(); ++i) {
-                    if (list.columnNames[i] == colName) {
-                        Cell &cell = task.extraColumns[i];
-                        cout << "Enter new value for '" << colName << "': ";
-                        switch (cell.type) {
-                            case DT_INT: cin >> cell.intValue; cin.ignore(); break;
-                            case DT_STRING: getline(cin, cell.stringValue); break;
-                            case DT_BOOL: cell.boolValue = readBoolInput(); break;
-                            case DT_FLOAT: cin >> cell.floatValue; cin.ignore(); break;
-                            case DT_DATE: getline(cin, cell.dateValue); break;
-                            default: getline(cin, cell.stringValue); break;
-                        }
-                        found = true;
-                        break;
-                    }
-                }
-                if (!found) {
-                    cout << "⚠️ Column not found!\n";
-                    return;
-                }
-            }
-
-            cout << "✅ Update complete.\n";
-            return;
-        }
+    if (findRow(list, id) == NO_ROW) {
+        cout << "❌ Task ID not found!\n";
+        return;
+    }
+    int col = -1;
+    if (colName == "TaskName") cout << "New Task Name: ";
+    else if (colName == "Priority") cout << "New Priority: ";
+    else if (colName == "Deadline") cout << "New Deadline (dd/mm/yyyy hh:mm): ";
+    else if (colName == "Status") cout << "New Status: ";
+    else if ((col = findColumn(list, colName)) >= 0) cout << "Enter new value for '" << colName << "': ";
+    else {
+        cout << "⚠️ Column not found!\n";
+        return;
     }
 
-    cout << "❌ Task ID not found!\n";
+    // updateTaskField checks the value against the column's type
+    string value, error;
+    while (true) {
+        if (col >= 0 && list.columnTypes[col] == DT_BOOL) value = readBoolInput() ? "true" : "false";
+        else if (!getline(cin, value)) return;
+        if (updateTaskField(list, undo, id, colName, value, error)) break;
+        cout << "❌ " << error << ". Try again: ";
+    }
+    cout << "✅ Update complete.\n";
 }
 
-
-void deleteTask(ToDoList &list) {
+void deleteTask(ToDoList &list, UndoLog &undo) {
     int id; cout << "Enter Task ID to delete: "; cin >> id; cin.ignore();
-    auto it = remove_if(list.tasks.begin(), list.tasks.end(), [id](Task &t) { return t.id == id; });
-    if (it != list.tasks.end()) {
-        list.tasks.erase(it, list.tasks.end());
-        cout << "Task deleted.\n";
-    } else {
-        cout << "Task not found.\n";
-    }
+    if (deleteTaskById(list, undo, id)) cout << "Task deleted.\n";
+    else cout << "Task not found.\n";
 }
 
-
-void deleteColumn(ToDoList &list) {
+void deleteColumn(ToDoList &list, UndoLog &undo) {
     string colName;
     cout << "Enter column name to delete: ";
     getline(cin, colName);
-
-    auto it = find(list.columnNames.begin(), list.columnNames.end(), colName);
-
-    if (it != list.columnNames.end()) {
-        int index = distance(list.columnNames.begin(), it);
-
-        // Remove from structure
-        list.columnNames.erase(it);
-        list.columnTypes.erase(list.columnTypes.begin() + index);
-
-        for (auto &task : list.tasks)
-            task.extraColumns.erase(task.extraColumns.begin() + index);
-
-        cout << "✅ Column '" << colName << "' deleted.\n";
-    } else {
-        cout << "❌ Column '" << colName << "' not found.\n";
-    }
+    if (deleteColumnByName(list, undo, colName)) cout << "✅ Column '" << colName << "' deleted.\n";
+    else cout << "❌ Column '" << colName << "' not found.\n";
 }
 
-
 void saveToCSV(const ToDoList &list) {
     string fname;
     cout << "Enter filename to save: ";
     getline(cin, fname);
-    ofstream out(fname + ".csv");
-    out << "ID,Name,Priority,Deadline,Status";
-    for (auto col : list.columnNames) out << "," << csvEscape(col);
-    out << "\n";
+    if (writeCSV(list, fname + ".csv")) cout << "Saved to " << fname << ".csv\n";
+    else cout << "❌ Could not write " << fname << ".csv\n";
+}
 
-    for (auto &t : list.tasks) {
-        out << t.id << "," << csvEscape(t.name) << "," << csvEscape(t.priority) << ","
-            << csvEscape(t.deadline) << "," << csvEscape(t.status);
-        for (auto &cell : t.extraColumns)
-            out << "," << csvEscape(cell.getAsString());
-        out << "\n";
-    }
-    out.close();
-    cout << "Saved to " << fname << ".csv\n";
+void printColumnTypes(const ToDoList &list) {
+    if (list.columnNames.empty()) return;
+    cout << "Column types:";
+    for (size_t i = 0; i < list.columnNames.size(); ++i)
+        cout << (i ? ", " : " ") << list.columnNames[i] << " (" << dataTypeName(list.columnTypes[i]) << ")";
+    cout << "\n";
+}
+
+void printMalformedRows(const CSVLoadStats &stats) {
+    for (const auto &row : stats.malformedRows)
+        cout << "⚠️ Skipping malformed row (invalid ID): " << row << "\n";
 }
 
-void loadFromCSV(ToDoList &list) {
+void loadFromCSV(ToDoList &list, UndoLog &undo) {
     string fname;
     cout << "Enter filename to load: ";
     getline(cin, fname);
@@ -460,133 +582,130 @@ void loadFromCSV(ToDoList &list) {
         cout << "File not found.\n";
         return;
     }
+    cout << "Detect column types (int/float/bool/date) if the file has no type row? (y/n): ";
+    bool inferTypes = readBoolInput();
 
-    string line;
-    getline(in, line);
+    ToDoList fresh;
+    fresh.name = list.name;
+    CSVLoadStats stats;
+    readCSVStream(fresh, in, inferTypes, stats);
+    printMalformedRows(stats);
+    replaceList(list, move(fresh), undo);
 
-    // Extract all column names
-    vector<string> headers = parseCSVLine(line);
+    cout << "Loaded successfully.\n";
+    printColumnTypes(list);
+}
 
-    // First 5 columns are standard fields and the rest are extra columns
-    list.columnNames.clear();
-    for (size_t i = 5; i < headers.size(); ++i) {
-        list.columnNames.push_back(headers[i]);
-        list.columnTypes.push_back(DT_STRING); // Default all loaded columns to string
+void printLoadStats(const CSVLoadStats &stats) {
+    double secs = stats.seconds > 0 ? stats.seconds : 1e-9;
+    cout << fixed << setprecision(3)
+         << "Loaded " << stats.rows << " rows (" << stats.bytes << " bytes) in "
+         << stats.seconds * 1000.0 << " ms on " << stats.threads << " thread(s) — "
+         << setprecision(0) << stats.rows / secs << " rows/sec, "
+         << setprecision(2) << stats.bytes / secs / (1024.0 * 1024.0) << " MB/sec\n";
+    cout.unsetf(ios::floatfield);
+    cout << setprecision(6);
+    if (stats.skipped > 0)
+        cout << "Skipped " << stats.skipped << " malformed row(s).\n";
+}
+
+void fastLoadFromCSV(ToDoList &list, UndoLog &undo) {
+    string fname;
+    cout << "Enter filename to load: ";
+    getline(cin, fname);
+    cout << "Detect column types (int/float/bool/date) if the file has no type row? (y/n): ";
+    bool inferTypes = readBoolInput();
+
+    CSVLoadStats stats;
+    ToDoList loaded;
+    loaded.name = list.name;
+    if (!loadCSVMapped(loaded, fname + ".csv", stats, inferTypes)) {
+        cout << "File not found.\n";
+        return;
     }
-    
-    list.tasks.clear();
-    while (getline(in, line)) {
-        if (line.empty()) continue;
-        vector<string> tokens = parseCSVLine(line);
+    printMalformedRows(stats);
+    replaceList(list, move(loaded), undo);
+    cout << "Loaded successfully.\n";
+    printLoadStats(stats);
+    printColumnTypes(list);
+}
 
-        if (tokens.size() < 5) continue;
 
-        Task t;
-        try {
-            t.id = stoi(tokens[0]);
-        } catch (...) {
-            cout << "⚠️ Skipping malformed row (invalid ID): " << line << "\n";
-            continue;
-        }
-        t.name = tokens[1];
-        t.priority = tokens[2];
-        t.deadline = tokens[3];
-        t.status = tokens[4];
+// ---------- Binary snapshots ----------
 
-        for (size_t i = 5; i < tokens.size(); ++i) {
-            Cell c;
-            c.setValue(tokens[i]);
-            t.extraColumns.push_back(c);
-        }
+void saveSnapshot(const ToDoList &list) {
+    string fname;
+    cout << "Enter filename to save: ";
+    getline(cin, fname);
+    if (writeSnapshot(list, fname + ".tbs")) cout << "💾 Snapshot saved to " << fname << ".tbs\n";
+    else cout << "❌ Could not write " << fname << ".tbs\n";
+}
 
-        list.tasks.push_back(t);
-    }
+void openSnapshot(ToDoList &list, UndoLog &undo) {
+    string fname;
+    cout << "Enter filename to open: ";
+    getline(cin, fname);
 
-    int maxId = 0;
-    for (const auto& t : list.tasks) {
-        if (t.id > maxId) maxId = t.id;
+    auto start = chrono::steady_clock::now();
+    ToDoList loaded;
+    loaded.name = list.name;
+    string error;
+    if (!readSnapshot(loaded, fname + ".tbs", error)) {
+        cout << "❌ Could not open " << fname << ".tbs: " << error << "\n";
+        return;
     }
-    list.nextId = maxId + 1;
-
-    cout << "Loaded successfully.\n";
+    replaceList(list, move(loaded), undo);
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    cout << fixed << setprecision(3) << "Opened " << list.tasks.size() << " rows in " << ms << " ms\n";
+    cout.unsetf(ios::floatfield);
+    cout << setprecision(6);
 }
 
 
-void sortByColumn(ToDoList &list) {
+// ---------- Sorting ----------
+
+void sortByColumn(ToDoList &list, UndoLog &undo) {
     cout << "\nWhich column do you want to sort by?\n";
-    cout << "0 - ID\n1 - Task Name\n2 - Priority\n3 - Deadline\n4 - Status\n";
+    cout << "0 - ID\n1 - Task Name\n2 - Priority (High first)\n3 - Deadline (earliest first)\n4 - Status\n";
 
     // List custom columns dynamically
-    for (int i = 0; i < list.columnNames.size(); ++i) {
+    for (size_t i = 0; i < list.columnNames.size(); ++i) {
         cout << (i + 5) << " - " << list.columnNames[i] << "\n";
     }
 
-    int choice;
-    cout << "Enter column index: ";
-    cin >> choice;
-    cin.ignore();
-
-    if (choice == 0) {
-        sort(list.tasks.begin(), list.tasks.end(), [](const Task &a, const Task &b) {
-            return a.id < b.id;
-        });
-    } else if (choice == 1) {
-        sort(list.tasks.begin(), list.tasks.end(), [](const Task &a, const Task &b) {
-            return a.name < b.name;
-        });
-    } else if (choice == 2) {
-        sort(list.tasks.begin(), list.tasks.end(), [](const Task &a, const Task &b) {
-            return a.priority < b.priority;
-        });
-    } else if (choice == 3) {
-        sort(list.tasks.begin(), list.tasks.end(), [](const Task &a, const Task &b) {
-            return a.deadline < b.deadline;
-        });
-    } else if (choice == 4) {
-        sort(list.tasks.begin(), list.tasks.end(), [](const Task &a, const Task &b) {
-            return a.status < b.status;
-        });
-    } else if (choice >= 5 && choice < 5 + list.columnNames.size()) {
-        int colIndex = choice - 5;
-        DataType dtype = list.columnTypes[colIndex];
-
-        // Sort by type
-        switch (dtype) {
-            case DT_INT:
-                sort(list.tasks.begin(), list.tasks.end(), [colIndex](const Task &a, const Task &b) {
-                    return a.extraColumns[colIndex].intValue < b.extraColumns[colIndex].intValue;
-                });
-                break;
-            case DT_STRING:
-            case DT_DATE:
-            case DT_LINK:
-                sort(list.tasks.begin(), list.tasks.end(), [colIndex](const Task &a, const Task &b) {
-                    return a.extraColumns[colIndex].stringValue < b.extraColumns[colIndex].stringValue;
-                });
-                break;
-            case DT_BOOL:
-                sort(list.tasks.begin(), list.tasks.end(), [colIndex](const Task &a, const Task &b) {
-                    return a.extraColumns[colIndex].boolValue < b.extraColumns[colIndex].boolValue;
-                });
-                break;
-            case DT_FLOAT:
-                sort(list.tasks.begin(), list.tasks.end(), [colIndex](const Task &a, const Task &b) {
-                    return a.extraColumns[colIndex].floatValue < b.extraColumns[colIndex].floatValue;
-                });
-                break;
-        }
-    } else {
+    cout << "Enter column index, or several separated by commas, most important first\n"
+            "(prefix with - for descending, e.g. 4,3,2): ";
+    string input;
+    getline(cin, input);
+    vector<SortKey> keys;
+    if (!parseSortKeys(input, list.columnNames.size(), keys)) {
         cout << "Invalid column index.\n";
         return;
     }
-
+    sortRows(list, undo, keys);
     cout << "Sorted successfully.\n";
 }
- 
- 
+
+
+// ---------- Filter expressions ----------
+
 void filterTasks(ToDoList &list) {
-    stack<vector<Task>> filterHistory;
-    vector<Task> filteredTasks = list.tasks;
+    // Filters work on a bitmap of rows in list.tasks, so narrowing and
+    // undoing only ever copies bits, never tasks. The list isn't changed
+    // while filtering, so its column store stays valid throughout.
+    const ColumnStore &cols = columnsOf(list);
+    stack<RowBitmap> filterHistory;
+    RowBitmap selected(cols.rows, true);
+
+    // Keeps `matched` as the new selection unless nothing matched.
+    auto narrowTo = [&](RowBitmap &matched) {
+        if (matched.count() == 0) {
+            cout << "No tasks match that filter.\n";
+            return;
+        }
+        filterHistory.push(move(selected));
+        selected = move(matched);
+    };
 
     while (true) {
         cout << "\nFilter Menu:\n";
@@ -595,6 +714,7 @@ void filterTasks(ToDoList &list) {
         cout << "3. Undo last filter\n";
         cout << "4. Show filtered tasks\n";
         cout << "5. Exit filtering\n";
+        cout << "6. Filter by expression (e.g. priority=High AND deadline < 01/08/2026 00:00)\n";
         cout << "Enter choice: ";
 
         int choice;
@@ -608,27 +728,47 @@ void filterTasks(ToDoList &list) {
             cout << "Enter value to filter by: ";
             getline(cin, value);
 
-            filterHistory.push(filteredTasks);
-            vector<Task> newFiltered;
-
-            for (const auto &task : filteredTasks) {
-                if ((colName == "id" && to_string(task.id) == value) ||
-                    (colName == "name" && task.name == value) ||
-                    (colName == "priority" && task.priority == value) ||
-                    (colName == "status" && task.status == value) ||
-                    (colName == "deadline" && task.deadline == value)) {
-                    newFiltered.push_back(task);
+            MetricTimer timer(METRIC_FILTER);
+            timer.rows = cols.rows;
+            RowBitmap matched(cols.rows);
+
+            const StringColumn *textCol = nullptr;
+            if (colName == "name") textCol = &cols.names();
+            else if (colName == "deadline") textCol = &cols.deadlines();
+
+            // Priority and status compare codes: one lookup for the value,
+            // then integer compares (a value the list has never seen can't match).
+            const vector<uint32_t> *codeCol = nullptr;
+            uint32_t wantedCode = 0;
+            bool known = false;
+            if (colName == "priority") { codeCol = &cols.priorities(); known = list.priorities.find(value, wantedCode); }
+            else if (colName == "status") { codeCol = &cols.statuses(); known = list.statuses.find(value, wantedCode); }
+
+            if (textCol != nullptr) {
+                // String compares only for rows still selected.
+                selected.forEach([&](size_t r) {
+                    if (textCol->at(r) == value) matched.set(r);
+                });
+            } else if (codeCol != nullptr) {
+                if (known) {
+                    matched = matchColumn(*codeCol, wantedCode);
+                    matched.andWith(selected);
+                }
+            } else if (colName == "id") {
+                int wantedId;
+                if (parseIntText(value, wantedId)) {
+                    matched = matchColumn(cols.ids(), wantedId);
+                    matched.andWith(selected);
                 }
             }
 
-            if (newFiltered.empty()) cout << "No tasks match that filter.\n";
-            else filteredTasks = newFiltered;
+            narrowTo(matched);
         }
 
         else if (choice == 2) {
             string colName, value;
             cout << "Available extra columns:\n";
-            for (int i = 0; i < list.columnNames.size(); ++i) {
+            for (size_t i = 0; i < list.columnNames.size(); ++i) {
                 cout << i << ": " << list.columnNames[i] << "\n";
             }
             cout << "Enter column index to filter by: ";
@@ -636,7 +776,7 @@ void filterTasks(ToDoList &list) {
             cin >> idx;
             cin.ignore();
 
-            if (idx < 0 || idx >= list.columnNames.size()) {
+            if (idx < 0 || (size_t)idx >= list.columnNames.size()) {
                 cout << "Invalid index.\n";
                 continue;
             }
@@ -644,52 +784,43 @@ void filterTasks(ToDoList &list) {
             cout << "Enter value to filter by: ";
             getline(cin, value);
 
-            filterHistory.push(filteredTasks);
-            vector<Task> newFiltered;
-            for (const auto &task : filteredTasks) {
-                if (idx < task.extraColumns.size() &&
-                    task.extraColumns[idx].getAsString() == value) {
-                    newFiltered.push_back(task);
-                }
-            }
-
-            if (newFiltered.empty()) cout << "No tasks match that filter.\n";
-            else filteredTasks = newFiltered;
+            MetricTimer timer(METRIC_FILTER);
+            timer.rows = cols.rows;
+            Cell wanted;
+            setCellFromText(wanted, list.columnTypes[idx], value);
+            long long wantedDate = 0;
+            wanted.getDateMinutes(wantedDate);
+
+            const ExtraColumn &col = cols.extra(idx);
+            RowBitmap matched(cols.rows);
+            selected.forEach([&](size_t r) {
+                if (extraCellMatches(list, col, idx, r, wanted, wantedDate, value))
+                    matched.set(r);
+            });
+
+            narrowTo(matched);
         }
 
         else if (choice == 3) {
             if (filterHistory.empty()) {
                 cout << "No filter to undo.\n";
             } else {
-                filteredTasks = filterHistory.top();
+                selected = move(filterHistory.top());
                 filterHistory.pop();
                 cout << "Undid last filter.\n";
             }
         }
 
         else if (choice == 4) {
-            if (filteredTasks.empty()) {
+            if (selected.count() == 0) {
                 cout << "No tasks to show.\n";
             } else {
                 cout << "\nFiltered Task List:\n";
-                cout << left << setw(5) << "ID" << setw(20) << "Task Name"
-                     << setw(10) << "Priority" << setw(20) << "Deadline"
-                     << setw(15) << "Status";
-
-                for (const auto &col : list.columnNames)
-                    cout << setw(15) << col;
-                cout << "\n";
-
-                for (const auto &task : filteredTasks) {
-                    cout << left << setw(5) << task.id
-                         << setw(20) << task.name
-                         << setw(10) << task.priority
-                         << setw(20) << task.deadline
-                         << setw(15) << task.status;
-                    for (const auto &cell : task.extraColumns)
-                        cout << setw(15) << cell.getAsString();
-                    cout << "\n";
-                }
+                vector<size_t> rows;
+                rows.reserve(selected.count());
+                selected.forEach([&rows](size_t r) { rows.push_back(r); });
+                static TablePrinter printer(15, 13);
+                showTable(list, &rows, printer);
             }
         }
 
@@ -698,51 +829,149 @@ void filterTasks(ToDoList &list) {
             break;
         }
 
+        else if (choice == 6) {
+            cout << "Columns: id, name, priority, deadline, status";
+            for (const auto &col : list.columnNames) cout << ", " << col;
+            cout << "\nCombine with AND, OR, NOT and ( ); compare with = != < <= > >=.\n";
+            cout << "Expression: ";
+            string text;
+            getline(cin, text);
+
+            FilterExpr expr;
+            FilterNode plan;
+            string error;
+            if (!parseFilterExpr(text, expr, error) || !compileFilter(expr, list, cols, plan, error)) {
+                cout << "⚠️ " << error << "\n";
+                continue;
+            }
+            auto start = chrono::steady_clock::now();
+            RowBitmap matched(cols.rows);
+            {
+                MetricTimer timer(METRIC_FILTER);
+                timer.rows = selected.count();
+                runFilter(plan, selected, matched);
+            }
+            double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+            cout << "Matched " << matched.count() << " of " << selected.count() << " row(s) in "
+                 << fixed << setprecision(3) << ms << " ms.\n" << defaultfloat;
+            narrowTo(matched);
+        }
+
         else {
             cout << "Invalid choice.\n";
         }
     }
 }
 
+// "850 ns", "12.4 µs", "3.21 ms", "1.50 s"
+string formatNanos(uint64_t ns) {
+    char buf[32];
+    if (ns < 1000) snprintf(buf, sizeof(buf), "%llu ns", (unsigned long long)ns);
+    else if (ns < 1000000) snprintf(buf, sizeof(buf), "%.1f µs", ns / 1e3);
+    else if (ns < 1000000000) snprintf(buf, sizeof(buf), "%.2f ms", ns / 1e6);
+    else snprintf(buf, sizeof(buf), "%.2f s", ns / 1e9);
+    return buf;
+}
+
+string formatBytes(uint64_t bytes) {
+    char buf[32];
+    if (bytes < 1024) snprintf(buf, sizeof(buf), "%llu B", (unsigned long long)bytes);
+    else if (bytes < (1 << 20)) snprintf(buf, sizeof(buf), "%.1f KB", bytes / 1024.0);
+    else snprintf(buf, sizeof(buf), "%.1f MB", bytes / (1024.0 * 1024.0));
+    return buf;
+}
+
+// One line per operation that has run at least once.
+void printMetrics() {
+    cout << left << setw(20) << "Operation" << right << setw(8) << "Runs" << setw(12) << "p50"
+         << setw(12) << "p99" << setw(12) << "Max" << setw(12) << "Rows" << setw(11) << "Read"
+         << setw(11) << "Written" << setw(10) << "Allocs" << "\n";
+    cout << string(108, '-') << "\n";
+    bool any = false;
+    for (int m = 0; m < METRIC_COUNT; ++m) {
+        const MetricStats &s = metrics[m];
+        uint64_t runs = s.count.load(memory_order_relaxed);
+        if (runs == 0) continue;
+        any = true;
+        // µs is one column wider than it is long in bytes
+        auto time = [](uint64_t ns) {
+            string t = formatNanos(ns);
+            return string(12 - min<size_t>(11, displayWidth(t)), ' ') + t;
+        };
+        cout << left << setw(20) << METRIC_NAMES[m] << right << setw(8) << runs << time(s.percentileNs(0.5))
+             << time(s.percentileNs(0.99)) << time(s.maxNs.load(memory_order_relaxed))
+             << setw(12) << s.rows.load(memory_order_relaxed)
+             << setw(11) << formatBytes(s.bytesIn.load(memory_order_relaxed))
+             << setw(11) << formatBytes(s.bytesOut.load(memory_order_relaxed))
+             << setw(10) << s.allocs.load(memory_order_relaxed) << "\n";
+    }
+    if (!any) cout << "(nothing timed yet)\n";
+    cout << left << "Heap allocations so far: " << totalAllocs.load(memory_order_relaxed) << " ("
+         << formatBytes(totalAllocBytes.load(memory_order_relaxed)) << ")\n" << right;
+}
 
 void getStats(const ToDoList &list) {
     cout << "Total tasks: " << list.tasks.size() << "\n";
-}
 
+    // Group counts are just histograms over the code columns.
+    const ColumnStore &cols = columnsOf(list);
+    auto printCounts = [&](const char *title, const vector<uint32_t> &codes, const SymbolTable &symbols) {
+        vector<size_t> counts(symbols.size(), 0);
+        for (uint32_t code : codes) ++counts[code];
+        cout << title << ":";
+        for (uint32_t c = 0; c < counts.size(); ++c)
+            if (counts[c] > 0) cout << "  " << (symbols.text(c).empty() ? "(blank)" : symbols.text(c)) << " " << counts[c];
+        cout << "\n";
+    };
+    if (cols.rows > 0) {
+        printCounts("By status", cols.statuses(), list.statuses);
+        printCounts("By priority", cols.priorities(), list.priorities);
+    }
+    cout << "\n=== Performance since start ===\n";
+    printMetrics();
+}
 
 void scheduleTasks(const ToDoList& list) {
-    priority_queue<Task, vector<Task>, CompareTasks> pq;
-    for (const auto& task : list.tasks) {
-        if (task.status == "Completed") continue;  // no point scheduling what's already done
-        pq.push(task);
-    }
+    cout << "How many tasks to show (0 = all)? ";
+    size_t count = 0;
+    if (!(cin >> count)) { cin.clear(); count = 0; }
+    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+    if (count == 0) count = list.schedule.size();
 
     cout << "\n=== Task Execution Order (Earliest Deadline, Priority breaks ties) ===\n\n";
-    if (pq.empty()) {
+    if (list.schedule.size() == 0) {
         cout << "No pending tasks to schedule.\n";
         return;
     }
-    while (!pq.empty()) {
-        Task t = pq.top(); pq.pop();
+    // Read the next tasks straight off the long-lived heap.
+    for (const auto &e : list.schedule.peek(count)) {
+        const Task &t = list.tasks[findRow(list, e.id)];
         cout << "Task #" << t.id << ": " << t.name
-             << " [Priority: " << t.priority
-             << ", Deadline: " << t.deadline << ", Status: " << t.status << "]\n";
+             << " [Priority: " << list.priorities.text(t.priority)
+             << ", Deadline: " << t.deadline << ", Status: " << list.statuses.text(t.status) << "]\n";
     }
 }
 
+// Best matches first: a word in the task name counts more than one in a
+// text column, and rare words more than common ones.
+void searchBoard(ToDoList &list) {
+    string query;
+    cout << "Enter words to search for: ";
+    getline(cin, query);
+    enableTextIndex(list);
+    vector<size_t> rows;
+    for (const SearchHit &hit : searchTasks(list, query, list.tasks.size())) rows.push_back(hit.row);
+    if (rows.empty()) {
+        cout << "No tasks match \"" << query << "\".\n";
+        return;
+    }
+    cout << "🔎 " << rows.size() << " task(s) match, best first:\n";
+    static TablePrinter printer(25, 20);
+    showTable(list, &rows, printer);
+}
 
-//time_t parseDeadline(const string &deadline);
-
-void removeCompletedTasks(ToDoList &list) {
-    int before = list.tasks.size();
-
-    // Remove all tasks whose status is "Completed" (case-sensitive match)
-    list.tasks.erase(remove_if(list.tasks.begin(), list.tasks.end(), [](const Task &t) {
-        return t.status == "Completed";
-    }), list.tasks.end());
-
-    int after = list.tasks.size();
-    cout << "🗑️ Removed " << (before - after) << " completed task(s).\n";
+void removeCompletedTasks(ToDoList &list, UndoLog &undo) {
+    cout << "🗑️ Removed " << removeCompleted(list, undo) << " completed task(s).\n";
 }
 
 void viewFullCell(const ToDoList &list) {
@@ -754,82 +983,1948 @@ void viewFullCell(const ToDoList &list) {
     cout << "Enter column name (TaskName, Priority, Deadline, Status or extra column): ";
     getline(cin, column);
 
-    for (const auto &task : list.tasks) {
-        if (task.id == id) {
-            if (column == "TaskName") cout << "Full Task Name: " << task.name << "\n";
-            else if (column == "Priority") cout << "Full Priority: " << task.priority << "\n";
-            else if (column == "Deadline") cout << "Full Deadline: " << task.deadline << "\n";
-            else if (column == "Status") cout << "Full Status: " << task.status << "\n";
-            else {
-                auto it = find(list.columnNames.begin(), list.columnNames.end(), column);
-                if (it != list.columnNames.end()) {
-                    int idx = distance(list.columnNames.begin(), it);
-                    if (idx < task.extraColumns.size()) {
-                        cout << "Full Value of \"" << column << "\": "
-                             << task.extraColumns[idx].getAsString() << "\n";
-                    } else {
-                        cout << "No value for that column.\n";
-                    }
-                } else {
-                    cout << "Column name not found.\n";
-                }
+    size_t row = findRow(list, id);
+    if (row == NO_ROW) {
+        cout << "Task ID not found!\n";
+        return;
+    }
+    const Task &task = list.tasks[row];
+    if (column == "TaskName") cout << "Full Task Name: " << task.name << "\n";
+    else if (column == "Priority") cout << "Full Priority: " << list.priorities.text(task.priority) << "\n";
+    else if (column == "Deadline") cout << "Full Deadline: " << task.deadline << "\n";
+    else if (column == "Status") cout << "Full Status: " << list.statuses.text(task.status) << "\n";
+    else {
+        int idx = findColumn(list, column);
+        if (idx >= 0) {
+            if ((size_t)idx < task.extraColumns.size()) {
+                cout << "Full Value of \"" << column << "\": "
+                     << task.extraColumns[idx].getAsString() << "\n";
+            } else {
+                cout << "No value for that column.\n";
             }
-            return;
+        } else {
+            cout << "Column name not found.\n";
         }
     }
-    cout << "Task ID not found!\n";
 }
 
 
-int main() {
-    setlocale(LC_ALL, "en_US.UTF-8");
-    ToDoList todo;
-    todo.name = "Smart Task List";
-    stack<ToDoList> undoStack;
-    int choice;
-    SetConsoleOutputCP(CP_UTF8);
+// ---------- Batch mode (ToDoList --batch script|- [--json]) ----------
+// Runs one command per line with no prompts, for scripts and job systems.
+// Fields are separated by commas and may be quoted as in a CSV file:
+//
+//   add,<name>,<priority>,<deadline>[,<custom column value>...]
+//   bulk                 then one task per line in add's format, then "end"
+//   update,<id>,<TaskName|Priority|Deadline|Status|custom column>,<value>
+//   delete,<id>
+//   addcolumn,<name>,<INT|STRING|BOOL|FLOAT|DATE|LINK>[,<value for every row>]
+//   deletecolumn,<name>
+//   filter,<expression>  as in the filter menu, e.g. filter,Hours >= 4 AND status = Pending
+//   sort,<keys>          as in the sort menu, e.g. sort,4,3,-2
+//   schedule[,<count>]
+//   search,<words>[,<count>]  best matches first; every word must appear, parts of words match too
+//   alerts[,<count>]     pending tasks by due-date bucket, soonest first
+//   print[,<first row>[,<count>]]
+//   stats
+//   metrics              per-operation latency percentiles, rows, bytes and allocations
+//   removecompleted
+//   undo
+//   save,<file.csv>   load,<file.csv>   snapshot,<file.tbs>   open,<file.tbs>
+//
+// Blank lines and lines starting with # are skipped. With --json every
+// command prints one JSON object on a line of its own.
+
+void appendJsonString(string &out, string_view s) {
+    out += '"';
+    for (char ch : s) {
+        unsigned char c = ch;
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += ch;
+        } else if (c < 0x20) {
+            char buf[8];
+            snprintf(buf, sizeof(buf), "\\u%04x", c);
+            out += buf;
+        } else {
+            out += ch;
+        }
+    }
+    out += '"';
+}
 
-    while (true) {
-        displayMenu();
-        cout << "Enter your choice: ";
-        cin >> choice;
-        cin.ignore();
+void appendJsonCell(string &out, const Cell &c) {
+    char buf[64];
+    long long minutes;
+    switch (c.type()) {
+        case DT_INT: out.append(buf, to_chars(buf, buf + sizeof(buf), c.getInt()).ptr); return;
+        case DT_BOOL: out += c.getBool() ? "true" : "false"; return;
+        case DT_FLOAT:
+            if (!isfinite(c.getFloat())) out += "null";
+            else out.append(buf, to_chars(buf, buf + sizeof(buf), c.getFloat()).ptr);
+            return;
+        case DT_DATE:
+            if (c.getText().empty() && c.getDateMinutes(minutes))
+                return appendJsonString(out, string_view(buf, formatDateTimeTo(buf, sizeof(buf), minutes)));
+            return appendJsonString(out, c.getText());
+        default: return appendJsonString(out, c.getText());
+    }
+}
+
+void appendJsonTask(string &out, const ToDoList &list, const Task &t) {
+    out += "{\"id\":";
+    out += to_string(t.id);
+    out += ",\"name\":";
+    appendJsonString(out, t.name);
+    out += ",\"priority\":";
+    appendJsonString(out, list.priorities.text(t.priority));
+    out += ",\"deadline\":";
+    appendJsonString(out, t.deadline);
+    out += ",\"status\":";
+    appendJsonString(out, list.statuses.text(t.status));
+    for (size_t c = 0; c < t.extraColumns.size() && c < list.columnNames.size(); ++c) {
+        out += ',';
+        appendJsonString(out, list.columnNames[c]);
+        out += ':';
+        appendJsonCell(out, t.extraColumns[c]);
+    }
+    out += '}';
+}
+
+// A new task from name, priority, deadline and custom values starting at
+// fields[start]; missing custom values are left blank.
+bool taskFromFields(ToDoList &list, const vector<string> &fields, size_t start, Task &t, string &error) {
+    if (fields.size() < start + 3) {
+        error = "expected name, priority and deadline";
+        return false;
+    }
+    if (fields.size() - start - 3 > list.columnNames.size()) {
+        error = "more values than custom columns";
+        return false;
+    }
+    t.name = fields[start];
+    t.priority = list.priorities.intern(fields[start + 1]);
+    if (!setDeadline(t, fields[start + 2])) {
+        error = "invalid deadline '" + fields[start + 2] + "' (use dd/mm/yyyy hh:mm)";
+        return false;
+    }
+    t.status = STATUS_PENDING;
+    t.extraColumns.resize(list.columnNames.size());
+    for (size_t c = 0; c < list.columnNames.size(); ++c) {
+        string_view value = start + 3 + c < fields.size() ? string_view(fields[start + 3 + c]) : string_view();
+        if (!setTypedCell(t.extraColumns[c], list.columnTypes[c], value, error)) return false;
+    }
+    return true;
+}
+
+struct BatchRunner {
+    ToDoList &list;
+    UndoLog &undo;
+    bool json;
+    istream &in;
+    size_t line = 0;
+    size_t commands = 0;
+    size_t failed = 0;
+    string out;               // the current command's output
+    string *reply = nullptr;  // if set, output is appended here instead of printed
+    string unavailable;       // if set, every command fails with this error
+
+    BatchRunner(ToDoList &l, UndoLog &u, istream &input, bool asJson) : list(l), undo(u), json(asJson), in(input) {}
+
+    // Starts a command's JSON object; fields are appended with `,"key":`.
+    void begin(const string &command) {
+        out.clear();
+        if (!json) return;
+        out += "{\"line\":" + to_string(line) + ",\"command\":";
+        appendJsonString(out, command);
+    }
+    void finish(bool ok, const string &message, const string &error = "") {
+        ++commands;
+        if (!ok) ++failed;
+        if (json) {
+            out += ok ? ",\"ok\":true" : ",\"ok\":false,\"error\":";
+            if (!ok) appendJsonString(out, error);
+            out += "}\n";
+        } else if (ok) {
+            if (!message.empty()) out += "✅ " + message + "\n";
+        } else {
+            out += "❌ line " + to_string(line) + ": " + error + "\n";
+        }
+        if (reply) reply->append(out);
+        else fwrite(out.data(), 1, out.size(), stdout);
+    }
+    void rows(const vector<size_t> &selected) {
+        if (json) {
+            out += ",\"count\":" + to_string(selected.size()) + ",\"rows\":[";
+            for (size_t i = 0; i < selected.size(); ++i) {
+                if (i) out += ',';
+                appendJsonTask(out, list, list.tasks[selected[i]]);
+            }
+            out += ']';
+        } else {
+            TablePrinter printer(25, 20);
+            printer.print(list, &selected, 0, selected.size());
+        }
+    }
+
+    void bulk() {
+        vector<Task> batch;
+        string text, error;
+        size_t firstLine = line;
+        bool ended = false;
+        while (getline(in, text)) {
+            ++line;
+            if (!text.empty() && text.back() == '\r') text.pop_back();
+            if (text == "end") {
+                ended = true;
+                break;
+            }
+            if (text.empty()) continue;
+            batch.emplace_back();
+            if (!taskFromFields(list, parseCSVLine(text), 0, batch.back(), error)) {
+                error = "line " + to_string(line) + ": " + error;
+                break;
+            }
+        }
+        if (error.empty() && !ended) error = "bulk from line " + to_string(firstLine) + " has no \"end\"";
+        if (error.empty() && !unavailable.empty()) error = unavailable;
+        if (!error.empty()) {
+            // Skip the rest of the block so its rows aren't read as commands
+            while (!ended && getline(in, text)) {
+                ++line;
+                ended = text == "end" || text == "end\r";
+            }
+            return finish(false, "", error + "; nothing from this bulk was added");
+        }
+        int firstId = list.nextId;
+        size_t count = batch.size();
+        appendTasks(list, undo, move(batch));
+        if (json) out += ",\"added\":" + to_string(count) + ",\"firstId\":" + to_string(firstId);
+        finish(true, "Added " + to_string(count) + " task(s) from #" + to_string(firstId));
+    }
+
+    void run(const string &text) {
+        size_t comma = text.find(',');
+        string command = text.substr(0, comma);
+        string rest = comma == string::npos ? "" : text.substr(comma + 1);
+        vector<string> f = parseCSVLine(text);
+        string error;
+        begin(command);
+        if (!unavailable.empty() && command != "bulk") return finish(false, "", unavailable);
+
+        if (command == "add") {
+            vector<Task> one(1);
+            if (!taskFromFields(list, f, 1, one[0], error)) return finish(false, "", error);
+            int id = list.nextId;
+            appendTasks(list, undo, move(one));
+            if (json) out += ",\"id\":" + to_string(id);
+            return finish(true, "Added task #" + to_string(id));
+        }
+        if (command == "bulk") return bulk();
+        if (command == "update") {
+            int id;
+            if (f.size() != 4 || !parseIntText(f[1], id)) return finish(false, "", "expected update,<id>,<column>,<value>");
+            bool ok = updateTaskField(list, undo, id, f[2], f[3], error);
+            return finish(ok, "Updated task #" + f[1], error);
+        }
+        if (command == "delete") {
+            int id;
+            if (f.size() != 2 || !parseIntText(f[1], id)) return finish(false, "", "expected delete,<id>");
+            bool ok = deleteTaskById(list, undo, id);
+            return finish(ok, "Deleted task #" + f[1], "no task with id " + f[1]);
+        }
+        if (command == "addcolumn") {
+            DataType type;
+            if (f.size() < 3 || f.size() > 4 || !parseDataTypeName(f[2], type))
+                return finish(false, "", "expected addcolumn,<name>,<INT|STRING|BOOL|FLOAT|DATE|LINK>[,<value>]");
+            bool ok = addColumnWithValue(list, undo, f[1], type, f.size() == 4 ? f[3] : "", error);
+            return finish(ok, "Added column '" + f[1] + "'", error);
+        }
+        if (command == "deletecolumn") {
+            if (f.size() != 2) return finish(false, "", "expected deletecolumn,<name>");
+            bool ok = deleteColumnByName(list, undo, f[1]);
+            return finish(ok, "Deleted column '" + f[1] + "'", "no column '" + f[1] + "'");
+        }
+        if (command == "filter") {
+            const ColumnStore &cols = columnsOf(list);
+            FilterExpr expr;
+            FilterNode plan;
+            if (!parseFilterExpr(rest, expr, error) || !compileFilter(expr, list, cols, plan, error))
+                return finish(false, "", error);
+            RowBitmap all(cols.rows), matched(cols.rows);
+            for (size_t r = 0; r < cols.rows; ++r) all.set(r);
+            {
+                MetricTimer timer(METRIC_FILTER);
+                timer.rows = cols.rows;
+                runFilter(plan, all, matched);
+            }
+            vector<size_t> selected;
+            matched.forEach([&selected](size_t r) { selected.push_back(r); });
+            rows(selected);
+            return finish(true, "Matched " + to_string(selected.size()) + " task(s)");
+        }
+        if (command == "sort") {
+            vector<SortKey> keys;
+            if (!parseSortKeys(rest, list.columnNames.size(), keys)) return finish(false, "", "invalid sort keys '" + rest + "'");
+            sortRows(list, undo, keys);
+            return finish(true, "Sorted");
+        }
+        if (command == "schedule") {
+            int count = 0;
+            if (f.size() > 2 || (f.size() == 2 && (!parseIntText(f[1], count) || count < 0)))
+                return finish(false, "", "expected schedule[,<count>]");
+            vector<size_t> selected;
+            for (const auto &e : list.schedule.peek(count > 0 ? count : list.schedule.size()))
+                selected.push_back(findRow(list, e.id));
+            rows(selected);
+            return finish(true, "");
+        }
+        if (command == "search") {
+            int count = 20;
+            if (f.size() < 2 || f.size() > 3 || (f.size() == 3 && (!parseIntText(f[2], count) || count <= 0)))
+                return finish(false, "", "expected search,<words>[,<count>]");
+            enableTextIndex(list);
+            vector<size_t> selected;
+            for (const SearchHit &hit : searchTasks(list, f[1], count)) selected.push_back(hit.row);
+            rows(selected);
+            return finish(true, "Found " + to_string(selected.size()) + " task(s)");
+        }
+        if (command == "alerts") {
+            int count = 0;
+            if (f.size() > 2 || (f.size() == 2 && (!parseIntText(f[1], count) || count < 0)))
+                return finish(false, "", "expected alerts[,<count>]");
+            size_t shown = 0;
+            if (json) out += ",\"alerts\":[";
+            forEachAlert(list, nowWallMinutes(), [&](const char *label, int id) {
+                if (count > 0 && shown == (size_t)count) return;
+                if (json) {
+                    out += shown ? ",{\"bucket\":" : "{\"bucket\":";
+                    appendJsonString(out, label);
+                    out += ",\"id\":" + to_string(id) + '}';
+                } else {
+                    const Task &t = list.tasks[findRow(list, id)];
+                    out += string(label) + ":    Task #" + to_string(id) + " - \"" + t.name + "\" | Deadline: " + t.deadline + "\n";
+                }
+                ++shown;
+            });
+            if (json) out += ']';
+            return finish(true, "");
+        }
+        if (command == "print") {
+            int first = 0, count = 0;
+            if (f.size() > 3 || (f.size() >= 2 && (!parseIntText(f[1], first) || first < 0)) ||
+                (f.size() == 3 && (!parseIntText(f[2], count) || count < 0)))
+                return finish(false, "", "expected print[,<first row>[,<count>]]");
+            size_t from = min((size_t)first, list.tasks.size());
+            size_t to = count > 0 ? min(list.tasks.size(), from + count) : list.tasks.size();
+            vector<size_t> selected(to - from);
+            iota(selected.begin(), selected.end(), from);
+            rows(selected);
+            return finish(true, "");
+        }
+        if (command == "stats") {
+            if (!json) {
+                cout.flush();
+                getStats(list);
+                return finish(true, "");
+            }
+            const ColumnStore &cols = columnsOf(list);
+            auto counts = [&](const char *key, const vector<uint32_t> &codes, const SymbolTable &symbols) {
+                vector<size_t> n(symbols.size(), 0);
+                for (uint32_t code : codes) ++n[code];
+                out += ",\"" + string(key) + "\":{";
+                bool first = true;
+                for (uint32_t c = 0; c < n.size(); ++c) {
+                    if (n[c] == 0) continue;
+                    if (!first) out += ',';
+                    first = false;
+                    appendJsonString(out, symbols.text(c));
+                    out += ':' + to_string(n[c]);
+                }
+                out += '}';
+            };
+            out += ",\"tasks\":" + to_string(list.tasks.size());
+            counts("byStatus", cols.statuses(), list.statuses);
+            counts("byPriority", cols.priorities(), list.priorities);
+            return finish(true, "");
+        }
+        if (command == "metrics") {
+            if (json) out += ",\"metrics\":" + metricsJSON();
+            else printMetrics();
+            return finish(true, "");
+        }
+        if (command == "removecompleted") {
+            size_t removed = removeCompleted(list, undo);
+            if (json) out += ",\"removed\":" + to_string(removed);
+            return finish(true, "Removed " + to_string(removed) + " completed task(s)");
+        }
+        if (command == "undo") {
+            bool ok = undoLast(list, undo);
+            return finish(ok, "Undid the last change", "nothing to undo");
+        }
+        if (command == "save" || command == "snapshot") {
+            if (f.size() != 2) return finish(false, "", "expected " + command + ",<file>");
+            bool ok = command == "save" ? writeCSV(list, f[1]) : writeSnapshot(list, f[1]);
+            return finish(ok, "Saved " + f[1], "could not write " + f[1]);
+        }
+        if (command == "load" || command == "open") {
+            if (f.size() != 2) return finish(false, "", "expected " + command + ",<file>");
+            ToDoList loaded;
+            loaded.name = list.name;
+            CSVLoadStats stats;
+            bool ok = command == "load" ? loadCSVMapped(loaded, f[1], stats) : readSnapshot(loaded, f[1], error);
+            if (!ok) return finish(false, "", "could not open " + f[1] + (error.empty() ? "" : ": " + error));
+            replaceList(list, move(loaded), undo);
+            if (json) out += ",\"tasks\":" + to_string(list.tasks.size()) + ",\"skipped\":" + to_string(stats.skipped);
+            for (const auto &row : stats.malformedRows)
+                if (!json) out += "⚠️ Skipping malformed row (invalid ID): " + row + "\n";
+            return finish(true, "Opened " + f[1] + " (" + to_string(list.tasks.size()) + " tasks)");
+        }
+        finish(false, "", "unknown command '" + command + "'");
+    }
+
+    void runAll() {
+        string text;
+        while (getline(in, text)) {
+            ++line;
+            if (!text.empty() && text.back() == '\r') text.pop_back();
+            size_t start = text.find_first_not_of(" \t");
+            if (start == string::npos || text[start] == '#') continue;
+            run(text.substr(start));
+        }
+    }
+};
+
+// Returns the number of commands that failed.
+size_t runBatch(ToDoList &list, UndoLog &undo, istream &in, bool json) {
+    BatchRunner runner(list, undo, in, json);
+    runner.runAll();
+    if (json) printf("{\"commands\":%zu,\"failed\":%zu}\n", runner.commands, runner.failed);
+    else printf("🏁 %zu command(s), %zu failed\n", runner.commands, runner.failed);
+    fflush(stdout);
+    return runner.failed;
+}
+
+
+// ---------- Workspace batch mode (ToDoList --workspace <dir> --batch script|-) ----------
+// Batch mode over a workspace's boards. Two more commands:
+//
+//   board,<name>          the following commands run on this board (created
+//                         empty if new); a script starts on "main"
+//   across,<expression>   filter every board at once, soonest deadline first
+//
+// Scripts (and server connections) are split into runs of ordinary
+// commands, each handed whole to the board's worker, and these lines.
+
+enum RequestKind { REQUEST_COMMANDS, REQUEST_BOARD, REQUEST_ACROSS };
+
+// Line [pos, eol) without a trailing '\r'.
+string_view lineAt(const string &in, size_t pos, size_t eol) {
+    string_view text(in.data() + pos, eol - pos);
+    if (!text.empty() && text.back() == '\r') text.remove_suffix(1);
+    return text;
+}
+
+// A command line as BatchRunner::runAll sees it, leading blanks trimmed.
+string_view requestLine(const string &in, size_t pos, size_t eol) {
+    string_view text = lineAt(in, pos, eol);
+    while (!text.empty() && (text[0] == ' ' || text[0] == '\t')) text.remove_prefix(1);
+    return text;
+}
+
+// Everything after the command's first comma.
+string requestArgument(string_view text) {
+    size_t comma = text.find(',');
+    return comma == string_view::npos ? "" : string(text.substr(comma + 1));
+}
+
+// The next piece of `in` from `pos`, ending at `end`: a run of complete
+// ordinary commands, or a single board or across line. False if there's
+// no complete request yet; a bulk block is complete once its "end" line
+// is in. With `finished` no more input is coming (`in` then ends in a
+// newline), so a bulk block missing its "end" goes out as it is and the
+// board's BatchRunner reports it.
+bool nextRequests(const string &in, size_t pos, RequestKind &kind, size_t &end, bool finished) {
+    size_t start = pos, eol;
+    while ((eol = in.find('\n', pos)) != string::npos) {
+        string_view text = requestLine(in, pos, eol);
+        string_view command = text.substr(0, text.find(','));
+        if (command == "board" || command == "across") {
+            if (pos > start) break;
+            kind = command == "board" ? REQUEST_BOARD : REQUEST_ACROSS;
+            end = eol + 1;
+            return true;
+        }
+        if (command == "bulk") {
+            size_t last;
+            while ((last = in.find('\n', eol + 1)) != string::npos && lineAt(in, eol + 1, last) != "end") eol = last;
+            if (last == string::npos && !finished) break;
+            eol = last == string::npos ? in.size() - 1 : last;
+        }
+        pos = eol + 1;
+    }
+    kind = REQUEST_COMMANDS;
+    end = pos;
+    return pos > start;
+}
+
+void appendRequestError(string &out, bool json, size_t line, const char *command, const string &error) {
+    if (json) {
+        out += "{\"line\":" + to_string(line) + ",\"command\":\"" + command + "\",\"ok\":false,\"error\":";
+        appendJsonString(out, error);
+        out += "}\n";
+    } else {
+        out += "❌ line " + to_string(line) + ": " + error + "\n";
+    }
+}
+
+const char *const BOARD_NAME_ERROR = "expected board,<name>, the name made of letters, digits, '-', '_' and '.'";
+
+void appendBoardReply(string &out, bool json, size_t line, const string &name, size_t tasks) {
+    if (json) {
+        out += "{\"line\":" + to_string(line) + ",\"command\":\"board\",\"board\":";
+        appendJsonString(out, name);
+        out += ",\"tasks\":" + to_string(tasks) + ",\"ok\":true}\n";
+    } else {
+        out += "✅ On board " + name + " (" + to_string(tasks) + " task(s))\n";
+    }
+}
+
+void appendAcrossReply(string &out, bool json, size_t line, const vector<WorkspaceMatch> &matches, const string &error) {
+    if (!error.empty()) return appendRequestError(out, json, line, "across", error);
+    if (json) {
+        out += "{\"line\":" + to_string(line) + ",\"command\":\"across\",\"count\":" + to_string(matches.size()) + ",\"rows\":[";
+        for (size_t i = 0; i < matches.size(); ++i) {
+            const WorkspaceMatch &m = matches[i];
+            out += i ? ",{\"board\":" : "{\"board\":";
+            appendJsonString(out, m.board);
+            out += ",\"id\":" + to_string(m.id) + ",\"name\":";
+            appendJsonString(out, m.name);
+            out += ",\"priority\":";
+            appendJsonString(out, m.priority);
+            out += ",\"deadline\":";
+            appendJsonString(out, m.deadline);
+            out += ",\"status\":";
+            appendJsonString(out, m.status);
+            out += '}';
+        }
+        out += "],\"ok\":true}\n";
+    } else {
+        for (const WorkspaceMatch &m : matches)
+            out += m.board + ": Task #" + to_string(m.id) + " - \"" + m.name + "\" | " + m.priority + " | Deadline: " +
+                   m.deadline + " | " + m.status + "\n";
+        out += "✅ Matched " + to_string(matches.size()) + " task(s) across boards\n";
+    }
+}
+
+// Runs a run of ordinary commands on a workspace board, on its worker.
+BatchRunner runOnBoard(WorkspaceBoard &board, istream &in, bool json, size_t line, string *reply) {
+    BatchRunner runner(board.list, board.undo, in, json);
+    runner.line = line;
+    runner.reply = reply;
+    if (!board.error.empty()) runner.unavailable = "board " + board.name + " couldn't be read: " + board.error;
+    runner.runAll();
+    return runner;
+}
+
+// Writes back the changed boards, stops the workers and says what happened.
+void printWorkspaceStats(Workspace &ws, ostream &out) {
+    closeWorkspace(ws);
+    WorkspaceStats stats = workspaceStats(ws);
+    out << "🗂️ Workspace " << ws.directory << ": " << stats.boards << " board(s), read " << stats.loads
+        << " time(s), unloaded " << stats.evictions << " time(s) to stay under " << (ws.budgetBytes >> 20) << " MB\n";
+}
+
+// Returns the number of requests that failed.
+size_t runWorkspaceBatch(Workspace &ws, istream &in, bool json) {
+    string script((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    if (!script.empty() && script.back() != '\n') script += '\n';
+    string board = "main", out;
+    size_t pos = 0, end, line = 0, commands = 0, failed = 0;
+    RequestKind kind;
+    while (nextRequests(script, pos, kind, end, true)) {
+        string_view text = requestLine(script, pos, end - 1);
+        out.clear();
+        if (kind == REQUEST_COMMANDS) {
+            istringstream lines(script.substr(pos, end - pos));
+            auto counts = withBoard(ws, board, [&](WorkspaceBoard &b) {
+                BatchRunner runner = runOnBoard(b, lines, json, line, nullptr);
+                return array<size_t, 3>{runner.line, runner.commands, runner.failed};
+            }).get();
+            line = counts[0];
+            commands += counts[1];
+            failed += counts[2];
+        } else if (kind == REQUEST_BOARD) {
+            ++line;
+            ++commands;
+            string name = requestArgument(text);
+            if (validBoardName(name)) {
+                board = name;
+                size_t tasks = withBoard(ws, board, [](WorkspaceBoard &b) { return b.list.tasks.size(); }).get();
+                appendBoardReply(out, json, line, name, tasks);
+            } else {
+                appendRequestError(out, json, line, "board", BOARD_NAME_ERROR);
+                ++failed;
+            }
+        } else {
+            ++line;
+            ++commands;
+            vector<WorkspaceMatch> matches;
+            string error;
+            if (!queryWorkspace(ws, requestArgument(text), SIZE_MAX, matches, error)) ++failed;
+            appendAcrossReply(out, json, line, matches, error);
+        }
+        fwrite(out.data(), 1, out.size(), stdout);
+        pos = end;
+    }
+    if (json) printf("{\"commands\":%zu,\"failed\":%zu}\n", commands, failed);
+    else printf("🏁 %zu command(s), %zu failed\n", commands, failed);
+    fflush(stdout);
+    return failed;
+}
+
+
+// ---------- Scan kernel microbenchmark (ToDoList --bench-scan [file]) ----------
+
+// csvEscape as it was before the scan kernels: three separate find() passes.
+string csvEscapeThreeScans(const string &field) {
+    bool needsQuotes = field.find(',') != string::npos ||
+                        field.find('"') != string::npos ||
+                        field.find('\n') != string::npos;
+    if (!needsQuotes) return field;
+    string escaped = "\"";
+    for (char c : field) {
+        if (c == '"') escaped += "\"\"";
+        else escaped += c;
+    }
+    escaped += "\"";
+    return escaped;
+}
+
+// A board where long quoted descriptions make up most of the bytes,
+// which is the shape of our exported Desc-heavy files.
+string makeDescHeavyCSV(size_t rows) {
+    const char *words[] = {"review", "chapter", "notes,", "practice", "\"graphs\"", "trees",
+                           "revise", "problems", "and", "summary,", "lecture", "sql"};
+    string csv = "ID,Name,Priority,Deadline,Status,Desc\n";
+    unsigned seed = 12345;
+    for (size_t i = 1; i <= rows; ++i) {
+        string desc;
+        size_t len = 150 + (seed = seed * 1103515245 + 12345) % 300;
+        while (desc.size() < len) {
+            desc += words[((seed = seed * 1103515245 + 12345) >> 16) % 12];
+            desc += ' ';
+        }
+        csv += to_string(i) + ",Task " + to_string(i) + ",High,28/7/2026 12:00,Pending," + csvEscape(desc) + "\n";
+    }
+    return csv;
+}
+
+void benchScanKernels(const string &path) {
+    string owned;
+    if (!path.empty()) {
+        ifstream in(path, ios::binary);
+        if (!in) { cout << "Cannot open " << path << "\n"; return; }
+        owned.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+    } else {
+        owned = makeDescHeavyCSV(200000);
+    }
+    string_view data = owned;
+
+    vector<ScanKernels> kernels = availableScanKernels();
+    const ScanKernels active = scanKernels;
+    const int reps = 5;
+    double mb = data.size() / (1024.0 * 1024.0);
+
+    auto timeBest = [&](auto &&fn) {
+        double best = 1e30;
+        for (int r = 0; r < reps; ++r) {
+            auto t0 = chrono::steady_clock::now();
+            fn();
+            best = min(best, chrono::duration<double>(chrono::steady_clock::now() - t0).count());
+        }
+        return best;
+    };
+    auto report = [&](const string &label, double secs, size_t check) {
+        cout << "  " << left << setw(28) << label << right << fixed << setprecision(2)
+             << setw(10) << secs * 1000.0 << " ms" << setw(10) << mb / secs << " MB/s"
+             << "   (" << check << ")\n";
+    };
+
+    cout << "Scan kernel benchmark: " << data.size() << " bytes, active kernel: " << active.name << "\n";
+    cout << "Tokenize:\n";
+    size_t fieldsSeen = 0;
+    double secs = timeBest([&] {
+        fieldsSeen = 0;
+        size_t pos = 0;
+        string line;
+        while (pos < data.size()) {
+            size_t nl = data.find('\n', pos);
+            if (nl == string_view::npos) nl = data.size();
+            line.assign(data.data() + pos, nl - pos);   // what getline hands parseCSVLine
+            fieldsSeen += parseCSVLine(line).size();
+            pos = nl + 1;
+        }
+    });
+    report("getline + parseCSVLine", secs, fieldsSeen);
+
+    vector<CSVField> fields;
+    for (const auto &k : kernels) {
+        scanKernels = k;
+        secs = timeBest([&] {
+            fieldsSeen = 0;
+            const char *p = data.data(), *end = p + data.size();
+            while (p < end) {
+                p = parseCSVRecord(p, end, fields);
+                fieldsSeen += fields.size();
+            }
+        });
+        report(string("parseCSVRecord/") + k.name, secs, fieldsSeen);
+    }
+
+    // Export: escape every field of the file once, as saveToCSV does
+    scanKernels = active;
+    vector<string> values;
+    for (const char *p = data.data(), *end = p + data.size(); p < end;) {
+        p = parseCSVRecord(p, end, fields);
+        for (const auto &f : fields) {
+            values.emplace_back();
+            assignCSVField(values.back(), f);
+        }
+    }
+    cout << "Escape (" << values.size() << " fields):\n";
+    size_t outBytes = 0;
+    secs = timeBest([&] {
+        outBytes = 0;
+        for (const auto &v : values) outBytes += csvEscapeThreeScans(v).size();
+    });
+    report("three find() scans", secs, outBytes);
+    for (const auto &k : kernels) {
+        scanKernels = k;
+        secs = timeBest([&] {
+            outBytes = 0;
+            for (const auto &v : values) outBytes += csvEscape(v).size();
+        });
+        report(string("csvEscape/") + k.name, secs, outBytes);
+    }
+    scanKernels = active;
+    cout.unsetf(ios::floatfield);
+    cout << setprecision(6);
+}
+
+
+// ---------- Board generator (ToDoList --generate file.csv|file.tbs [options]) ----------
+// Builds boards shaped like Syllabus.csv at any size. The same options and
+// seed always give the same board, on every platform: the generator uses
+// its own splitmix64 stream rather than <random>'s distributions, and
+// deadlines count from a fixed date rather than from now.
+//
+//   --rows N                    tasks (default 100000)
+//   --seed N                    (default 1)
+//   --columns STRING,INT,...    custom column types in order (default STRING)
+//   --name-len N                average task name length (default 12)
+//   --text-len N                average STRING/LINK cell length (default 24)
+//   --priorities High=3,...     weights for each priority
+//   --statuses Pending=5,...    weights for each status
+
+struct BoardSpec {
+    size_t rows = 100000;
+    uint64_t seed = 1;
+    vector<DataType> columns = {DT_STRING};
+    size_t nameLength = 12;
+    size_t textLength = 24;
+    vector<pair<string, unsigned>> priorities = {{"High", 3}, {"Medium", 4}, {"Low", 3}};
+    vector<pair<string, unsigned>> statuses = {{"Pending", 5}, {"In progress", 3}, {"Completed", 2}};
+};
+
+// Deadlines fall in the year from here; benchmarks that depend on the
+// current time measure from the middle of it instead.
+const long long GENERATED_FROM_MINUTES = 29454720;   // 01/01/2026 00:00
+const long long GENERATED_SPAN_MINUTES = 365 * 1440;
+
+struct BoardRng {
+    uint64_t state;
+    uint64_t next() {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+    uint64_t below(uint64_t n) { return n == 0 ? 0 : next() % n; }
+};
+
+// "High=3,Medium=4,Low=3"
+bool parseWeights(const string &text, vector<pair<string, unsigned>> &weights) {
+    weights.clear();
+    for (const string &item : parseCSVLine(text)) {
+        size_t eq = item.rfind('=');
+        int w;
+        if (eq == string::npos || eq == 0 || !parseIntText(string_view(item).substr(eq + 1), w) || w < 0)
+            return false;
+        weights.emplace_back(item.substr(0, eq), (unsigned)w);
+    }
+    return !weights.empty();
+}
+
+// Reads generator options from argv; unknown options are left for the caller.
+bool parseBoardSpec(int argc, char *argv[], BoardSpec &spec, string &error) {
+    for (int i = 1; i + 1 < argc; ++i) {
+        string arg = argv[i];
+        string_view value = argv[i + 1];
+        int n = 0;
+        bool number = parseIntText(value, n) && n >= 0;
+        if (arg == "--rows" || arg == "--seed" || arg == "--name-len" || arg == "--text-len") {
+            if (!number) {
+                error = arg + " needs a number";
+                return false;
+            }
+            if (arg == "--rows") spec.rows = n;
+            else if (arg == "--seed") spec.seed = n;
+            else if (arg == "--name-len") spec.nameLength = max(1, n);
+            else spec.textLength = n;
+        } else if (arg == "--columns") {
+            spec.columns.clear();
+            for (const string &name : parseCSVLine(string(value))) {
+                DataType type;
+                if (!parseDataTypeName(name, type)) {
+                    error = "unknown column type '" + name + "'";
+                    return false;
+                }
+                spec.columns.push_back(type);
+            }
+        } else if (arg == "--priorities" || arg == "--statuses") {
+            if (!parseWeights(string(value), arg == "--priorities" ? spec.priorities : spec.statuses)) {
+                error = arg + " expects Name=weight,Name=weight,...";
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Words from which names and descriptions are strung together.
+const char *const BOARD_WORDS[] = {"DSA", "Resume", "UI", "Java", "OS", "DBMS", "Revise", "notes",
+                                   "Solve", "problems", "Build", "frontend", "Design", "webpage",
+                                   "Do", "OOPs", "graphs", "trees", "mock", "test", "SQL", "lab"};
+
+void appendWords(string &out, BoardRng &rng, size_t averageLength) {
+    // Lengths spread evenly over [average/2, 3*average/2]
+    size_t target = averageLength / 2 + rng.below(averageLength + 1);
+    while (out.size() < target) {
+        if (!out.empty()) out += ' ';
+        out += BOARD_WORDS[rng.below(size(BOARD_WORDS))];
+    }
+}
+
+uint32_t pickWeighted(BoardRng &rng, const vector<uint32_t> &codes, const vector<unsigned> &cumulative) {
+    if (cumulative.back() == 0) return codes[0];
+    uint64_t x = rng.below(cumulative.back());
+    return codes[upper_bound(cumulative.begin(), cumulative.end(), x) - cumulative.begin()];
+}
+
+void generateBoard(const BoardSpec &spec, ToDoList &list) {
+    list.tasks.clear();
+    list.columnNames.clear();
+    list.columnTypes.clear();
+    list.priorities = prioritySymbols();
+    list.statuses = statusSymbols();
+
+    // Column names after their type, numbered when a type repeats
+    const char *names[] = {"Hours", "Desc", "Done", "Score", "Start", "Link"};
+    int seen[6] = {};
+    for (DataType type : spec.columns) {
+        string name = names[type];
+        if (seen[type]++ > 0) name += to_string(seen[type]);
+        list.columnNames.push_back(name);
+        list.columnTypes.push_back(type);
+    }
+
+    auto weights = [](const vector<pair<string, unsigned>> &w, SymbolTable &symbols,
+                      vector<uint32_t> &codes, vector<unsigned> &cumulative) {
+        unsigned total = 0;
+        for (const auto &p : w) {
+            codes.push_back(symbols.intern(p.first));
+            cumulative.push_back(total += p.second);
+        }
+    };
+    vector<uint32_t> priorityCodes, statusCodes;
+    vector<unsigned> priorityWeights, statusWeights;
+    weights(spec.priorities, list.priorities, priorityCodes, priorityWeights);
+    weights(spec.statuses, list.statuses, statusCodes, statusWeights);
+
+    BoardRng rng{spec.seed};
+    char buf[32];
+    list.tasks.resize(spec.rows);
+    for (size_t r = 0; r < spec.rows; ++r) {
+        Task &t = list.tasks[r];
+        t.id = (int)r + 1;
+        appendWords(t.name, rng, spec.nameLength);
+        t.priority = pickWeighted(rng, priorityCodes, priorityWeights);
+        t.status = pickWeighted(rng, statusCodes, statusWeights);
+        long long due = GENERATED_FROM_MINUTES + rng.below(GENERATED_SPAN_MINUTES / 10) * 10;
+        setDeadline(t, string_view(buf, formatDateTimeTo(buf, sizeof(buf), due)));
+        t.extraColumns.resize(spec.columns.size());
+        for (size_t c = 0; c < spec.columns.size(); ++c) {
+            Cell &cell = t.extraColumns[c];
+            string text;
+            switch (spec.columns[c]) {
+                case DT_INT: cell.setValue((int)rng.below(40)); break;
+                case DT_FLOAT: cell.setValue((float)rng.below(10000) / 100.0f); break;
+                case DT_BOOL: cell.setValue(rng.below(2) == 1); break;
+                case DT_DATE: cell.setDateMinutes(due - (long long)rng.below(30 * 144) * 10); break;
+                case DT_LINK:
+                    appendWords(text, rng, spec.textLength);
+                    replace(text.begin(), text.end(), ' ', '-');
+                    cell.setLink("https://example.com/" + text);
+                    break;
+                default:
+                    appendWords(text, rng, spec.textLength);
+                    cell.setValue(text);
+                    break;
+            }
+        }
+    }
+    list.nextId = (int)spec.rows + 1;
+    reindexColumns(list);
+    rebuildIndexes(list);
+    markChanged(list);
+}
+
+int generateBoardFile(const string &path, const BoardSpec &spec) {
+    ToDoList list;
+    generateBoard(spec, list);
+    bool snapshot = path.size() > 4 && path.compare(path.size() - 4, 4, ".tbs") == 0;
+    if (!(snapshot ? writeSnapshot(list, path) : writeCSV(list, path))) {
+        cerr << "❌ Could not write " << path << "\n";
+        return 1;
+    }
+    cerr << "✅ Wrote " << spec.rows << " tasks to " << path << "\n";
+    return 0;
+}
+
+
+// ---------- Benchmark suite (ToDoList --bench [generator options] [--reps N] [--out file.json]) ----------
+// Times the board operations on a generated board and prints the results
+// as JSON, one entry per operation, so runs of different versions can be
+// compared. Progress goes to stderr.
+
+struct BenchResult {
+    string name;
+    size_t items;         // rows (or operations) each run handles
+    vector<double> ms;    // one per rep
+};
+
+struct BenchSuite {
+    int reps = 5;
+    vector<BenchResult> results;
+
+    // Runs setup() untimed and fn() timed, reps times.
+    template <class Setup, class F>
+    void run(const string &name, size_t items, Setup setup, F fn) {
+        BenchResult result{name, items, {}};
+        for (int r = 0; r < reps; ++r) {
+            setup();
+            auto t0 = chrono::steady_clock::now();
+            fn();
+            result.ms.push_back(chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count());
+        }
+        sort(result.ms.begin(), result.ms.end());
+        fprintf(stderr, "  %-32s %10.2f ms\n", name.c_str(), result.ms[0]);
+        results.push_back(move(result));
+    }
+    template <class F>
+    void run(const string &name, size_t items, F fn) {
+        run(name, items, [] {}, fn);
+    }
+};
+
+string benchJSON(const BenchSuite &suite, const BoardSpec &spec) {
+    string out = "{\n  \"benchmark\": \"taskboard\",\n  \"version\": 1,\n  \"board\": {\"rows\": " +
+                 to_string(spec.rows) + ", \"seed\": " + to_string(spec.seed) + ", \"columns\": [";
+    for (size_t c = 0; c < spec.columns.size(); ++c) {
+        if (c) out += ", ";
+        appendJsonString(out, dataTypeName(spec.columns[c]));
+    }
+    out += "], \"nameLength\": " + to_string(spec.nameLength) + ", \"textLength\": " +
+           to_string(spec.textLength) + "},\n  \"threads\": " + to_string(thread::hardware_concurrency()) +
+           ",\n  \"reps\": " + to_string(suite.reps) + ",\n  \"results\": [\n";
+    char buf[256];
+    for (size_t i = 0; i < suite.results.size(); ++i) {
+        const BenchResult &r = suite.results[i];
+        double mean = accumulate(r.ms.begin(), r.ms.end(), 0.0) / r.ms.size();
+        double best = r.ms.front();
+        out += "    {\"name\": ";
+        appendJsonString(out, r.name);
+        snprintf(buf, sizeof(buf),
+                 ", \"items\": %zu, \"best_ms\": %.3f, \"median_ms\": %.3f, \"mean_ms\": %.3f, "
+                 "\"items_per_sec\": %.0f}",
+                 r.items, best, r.ms[r.ms.size() / 2], mean, best > 0 ? r.items / (best / 1000) : 0.0);
+        out += buf;
+        out += i + 1 < suite.results.size() ? ",\n" : "\n";
+    }
+    out += "  ]\n}\n";
+    return out;
+}
+
+int runBenchmarks(int argc, char *argv[]) {
+    BoardSpec spec;
+    string error, outPath;
+    BenchSuite suite;
+    if (!parseBoardSpec(argc, argv, spec, error) || spec.rows == 0) {
+        cerr << "❌ " << (error.empty() ? "--rows must be at least 1" : error) << "\n";
+        return 1;
+    }
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (string(argv[i]) == "--reps") suite.reps = max(1, atoi(argv[i + 1]));
+        if (string(argv[i]) == "--out") outPath = argv[i + 1];
+    }
+
+    ToDoList board;
+    board.name = "Benchmark";
+    fprintf(stderr, "Benchmarking on %zu generated tasks, best of %d:\n", spec.rows, suite.reps);
+    suite.run("generate", spec.rows, [&] { generateBoard(spec, board); });
+    const size_t rows = board.tasks.size();
+
+    // CSV round trip through a scratch file
+    string csvPath = "taskboard_bench.csv";
+    suite.run("save/csv", rows, [&] { writeCSV(board, csvPath); });
+    suite.run("load/csv-stream", rows, [&] {
+        ifstream in(csvPath);
+        ToDoList loaded;
+        CSVLoadStats stats;
+        readCSVStream(loaded, in, false, stats);
+    });
+    suite.run("load/csv-mapped", rows, [&] {
+        ToDoList loaded;
+        CSVLoadStats stats;
+        loadCSVMapped(loaded, csvPath, stats);
+    });
+    remove(csvPath.c_str());
+
+    // Sort by every built-in column and each custom column type once.
+    // The untimed undo puts the rows back in generated order each time.
+    UndoLog undo;
+    vector<pair<string, int>> sortColumns = {{"ID", 0}, {"Name", 1}, {"Priority", 2}, {"Deadline", 3}, {"Status", 4}};
+    bool typeDone[6] = {};
+    for (size_t c = 0; c < board.columnTypes.size(); ++c) {
+        if (typeDone[board.columnTypes[c]]) continue;
+        typeDone[board.columnTypes[c]] = true;
+        sortColumns.emplace_back(dataTypeName(board.columnTypes[c]), (int)c + 5);
+    }
+    for (const auto &column : sortColumns) {
+        vector<SortKey> keys = {{column.second, false}};
+        suite.run("sort/" + column.first, rows, [&] { undoLast(board, undo); }, [&] { sortRows(board, undo, keys); });
+        undoLast(board, undo);
+    }
+    suite.run("sort/Status,Deadline,-Priority", rows, [&] { undoLast(board, undo); },
+              [&] { sortRows(board, undo, {{4, false}, {3, false}, {2, true}}); });
+    undoLast(board, undo);
+
+    // Filters: the menu's expressions on built-in and typed columns
+    char mid[32];
+    formatDateTimeTo(mid, sizeof(mid), GENERATED_FROM_MINUTES + GENERATED_SPAN_MINUTES / 2);
+    vector<string> filters = {"priority = High", "status != Completed AND deadline < " + string(mid),
+                              "NOT (priority = Low OR status = Pending)"};
+    for (size_t c = 0; c < board.columnTypes.size(); ++c) {
+        DataType type = board.columnTypes[c];
+        const string &col = board.columnNames[c];
+        if (type == DT_INT) filters.push_back(col + " >= 20");
+        if (type == DT_FLOAT) filters.push_back(col + " < 25.5");
+        if (type == DT_BOOL) filters.push_back(col + " = true AND priority = High");
+        if (type == DT_DATE) filters.push_back(col + " >= " + string(mid));
+    }
+    RowBitmap matched(0);
+    for (const string &text : filters) {
+        FilterExpr expr;
+        if (!parseFilterExpr(text, expr, error)) {
+            cerr << "❌ " << text << ": " << error << "\n";
+            continue;
+        }
+        suite.run("filter/" + text, rows, [&] {
+            const ColumnStore &cols = columnsOf(board);
+            FilterNode plan;
+            if (!compileFilter(expr, board, cols, plan, error)) return;
+            RowBitmap all(cols.rows);
+            for (size_t r = 0; r < cols.rows; ++r) all.set(r);
+            matched = RowBitmap(cols.rows);
+            runFilter(plan, all, matched);
+        });
+    }
+
+    // Schedule and alerts read the long-lived indexes
+    size_t seen = 0;
+    suite.run("schedule/next-10", 10, [&] { seen += board.schedule.peek(10).size(); });
+    suite.run("schedule/all", board.schedule.size(), [&] { seen += board.schedule.peek(board.schedule.size()).size(); });
+    suite.run("indexes/rebuild", rows, [&] { rebuildIndexes(board); });
+    long long now = GENERATED_FROM_MINUTES + GENERATED_SPAN_MINUTES / 2;
+    suite.run("alerts/categorize", board.dueIndex.byDeadline.size(), [&] {
+        forEachAlert(board, now, [&](const char *, int) { ++seen; });
+    });
+
+    // Text search: building the index once, then queries against it
+    enableTextIndex(board);
+    suite.run("text-index/build", rows, [&] { rebuildTextIndex(board); });
+    for (const char *query : {"graphs", "graph", "mock test sql", "kotlin"})
+        suite.run(string("search/") + query, rows, [&] { seen += searchTasks(board, query, 20).size(); });
+
+    // Undo: what recording and reverting a step costs. History keeps at
+    // most undo.maxSteps steps, so that many are reverted per run.
+    auto updateMany = [&](size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            size_t row = (i * 7919) % rows;
+            updateTaskField(board, undo, board.tasks[row].id, "TaskName", "renamed", error);
+        }
+    };
+    const size_t updates = min<size_t>(rows, 10000);
+    suite.run("undo/record-update", updates, [&] { updateMany(updates); });
+    suite.run("undo/revert-update", undo.maxSteps, [&] { updateMany(undo.maxSteps); }, [&] {
+        while (undoLast(board, undo)) {}
+    });
+    suite.run("undo/remove-completed", rows, [&] { undoLast(board, undo); }, [&] { removeCompleted(board, undo); });
+    suite.run("undo/restore-completed", rows, [&] { removeCompleted(board, undo); }, [&] { undoLast(board, undo); });
+    suite.run("undo/replace-list", rows, [&] {
+        ToDoList copy = board;
+        replaceList(board, move(copy), undo);
+    });
+
+    // Shared board: readers ask for the next tasks while a writer keeps
+    // renaming them. Items are reads, across all reader threads.
+    TaskBoard shared;
+    resetBoard(shared, ToDoList(board));
+    const size_t readsPerThread = 20000;
+    atomic<size_t> sharedSeen(0);
+    for (unsigned readers = 1; readers <= max(1u, thread::hardware_concurrency()); readers *= 2) {
+        suite.run("board/next-10, " + to_string(readers) + " reader(s) + writer", readers * readsPerThread, [&] {
+            atomic<bool> done(false);
+            thread writer([&] {
+                for (size_t i = 0; !done.load(); ++i) {
+                    int id = board.tasks[(i * 7919) % rows].id;
+                    editBoard(shared, [id](ToDoList &list, UndoLog &u) {
+                        string e;
+                        updateTaskField(list, u, id, "TaskName", "renamed", e);
+                    });
+                }
+            });
+            runOnThreads(readers, [&](unsigned) {
+                size_t local = 0;
+                for (size_t i = 0; i < readsPerThread; ++i) local += readBoard(shared)->list.schedule.peek(10).size();
+                sharedSeen += local;
+            });
+            done = true;
+            writer.join();
+        });
+    }
+    fprintf(stderr, "(%zu)\n", seen + matched.count() + sharedSeen);
+
+    string json = benchJSON(suite, spec);
+    if (outPath.empty()) {
+        fwrite(json.data(), 1, json.size(), stdout);
+    } else {
+        ofstream out(outPath);
+        out << json;
+        if (!out) {
+            cerr << "❌ Could not write " << outPath << "\n";
+            return 1;
+        }
+        cerr << "✅ Results written to " << outPath << "\n";
+    }
+    return 0;
+}
+
+// Opens a .tbs snapshot or a CSV file into `list`.
+bool openBoardFile(ToDoList &list, const string &path, string &error) {
+    if (path.size() > 4 && path.compare(path.size() - 4, 4, ".tbs") == 0) return readSnapshot(list, path, error);
+    CSVLoadStats stats;
+    bool ok = loadCSVMapped(list, path, stats, false);
+    if (!ok) error = "file not found";
+    printMalformedRows(stats);
+    return ok;
+}
+
+
+// ---------- Server mode (ToDoList --serve <address> [--board <name>=<file>... | --workspace <dir>]) ----------
+// Serves boards to many clients at once over a Unix-domain socket (an
+// address containing '/', e.g. /tmp/tasks.sock) or TCP ([host:]port, host
+// 127.0.0.1 unless given). The protocol is batch mode's: a request is one
+// command line (a bulk block counts as one), and every request gets one
+// JSON line back, in order, whose "line" is the request's line number on
+// that connection. Clients can therefore pipeline: send many requests,
+// then read the replies. board,<name> moves the connection to another
+// board, created empty the first time, and across,<expression> filters
+// every board; connections start on "main", the board from --open /
+// --journal.
+//
+// A single thread runs a poll() loop. Everything a read brings in is
+// executed at once, the journal is synced once for the whole round, and
+// each connection's replies go out in one write. A client that stops
+// reading isn't read from either until its replies drain. With
+// --workspace, the loop hands each request to its board's worker instead
+// and carries on; a connection's next request starts when the reply is
+// back, so requests on different boards run in parallel.
+
+#ifndef _WIN32
+
+const size_t SERVER_READ_BYTES = 64 << 10;    // per read()
+const size_t SERVER_MAX_BACKLOG = 4 << 20;    // unsent replies before a client stops being read
+const size_t SERVER_MAX_REQUEST = 64 << 20;   // a request (a bulk block) still unfinished past this is refused
+
+volatile sig_atomic_t serverStop = 0;
+
+void stopServer(int) { serverStop = 1; }
+
+// A Unix socket path, or [host:]port.
+bool parseSocketAddress(const string &address, sockaddr_storage &addr, socklen_t &len, string &error) {
+    memset(&addr, 0, sizeof(addr));
+    if (address.find('/') != string::npos) {
+        sockaddr_un &un = (sockaddr_un &)addr;
+        if (address.size() >= sizeof(un.sun_path)) {
+            error = "socket path too long";
+            return false;
+        }
+        un.sun_family = AF_UNIX;
+        memcpy(un.sun_path, address.data(), address.size());
+        len = sizeof(sockaddr_un);
+        return true;
+    }
+    size_t colon = address.rfind(':');
+    string host = colon == string::npos || colon == 0 ? "127.0.0.1" : address.substr(0, colon);
+    if (host == "localhost") host = "127.0.0.1";
+    int port;
+    if (!parseIntText(colon == string::npos ? address : address.substr(colon + 1), port) || port <= 0 || port > 65535) {
+        error = "expected a socket path or [host:]port, not '" + address + "'";
+        return false;
+    }
+    sockaddr_in &in = (sockaddr_in &)addr;
+    in.sin_family = AF_INET;
+    in.sin_port = htons((uint16_t)port);
+    if (inet_pton(AF_INET, host.c_str(), &in.sin_addr) != 1) {
+        error = "not an IPv4 address: '" + host + "'";
+        return false;
+    }
+    len = sizeof(sockaddr_in);
+    return true;
+}
+
+// A non-blocking listening socket, or -1.
+int listenOn(const string &address, string &error) {
+    sockaddr_storage addr;
+    socklen_t len;
+    if (!parseSocketAddress(address, addr, len, error)) return -1;
+    int fd = socket(addr.ss_family, SOCK_STREAM, 0);
+    if (fd < 0) {
+        error = strerror(errno);
+        return -1;
+    }
+    int one = 1;
+    struct stat st;
+    // A socket file left behind by an earlier run (never any other file)
+    if (addr.ss_family == AF_UNIX && stat(address.c_str(), &st) == 0 && S_ISSOCK(st.st_mode)) unlink(address.c_str());
+    if (addr.ss_family == AF_INET) setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (bind(fd, (sockaddr *)&addr, len) != 0 || listen(fd, SOMAXCONN) != 0) {
+        error = strerror(errno);
+        close(fd);
+        return -1;
+    }
+    fcntl(fd, F_SETFL, O_NONBLOCK);
+    return fd;
+}
+
+// A blocking connection to a server, or -1.
+int connectTo(const string &address, string &error) {
+    sockaddr_storage addr;
+    socklen_t len;
+    if (!parseSocketAddress(address, addr, len, error)) return -1;
+    int fd = socket(addr.ss_family, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (sockaddr *)&addr, len) != 0) {
+        error = strerror(errno);
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    int one = 1;
+    if (addr.ss_family == AF_INET) setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+bool writeAll(int fd, string_view data) {
+    while (!data.empty()) {
+        ssize_t n = write(fd, data.data(), data.size());
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        data.remove_prefix((size_t)n);
+    }
+    return true;
+}
+
+struct ServedBoard {
+    ToDoList list;
+    UndoLog undo;
+};
+
+struct Connection {
+    int fd;
+    string in, out;
+    size_t sent = 0;          // bytes of `out` already written
+    size_t line = 0;          // request lines received
+    size_t requests = 0;      // replies queued (a bulk block spans many lines)
+    string board = "main";
+    bool eof = false;         // the client has finished sending
+    bool broken = false;
+    bool busy = false;        // a request is running on a workspace worker
+
+    explicit Connection(int f) : fd(f) {}
+};
+
+// A request a workspace worker has finished.
+struct FinishedRequest {
+    int fd;
+    string reply;
+    size_t line;
+};
+
+struct Server {
+    map<string, ServedBoard> boards;   // without a workspace
+    Workspace *workspace = nullptr;
+    int wake[2] = {-1, -1};            // workers write a byte here when they finish a request
+    mutex lock;
+    vector<FinishedRequest> finished;  // under lock
+};
+
+void queueReply(Connection &conn, const string &reply) {
+    conn.out += reply;
+    conn.requests += count(reply.begin(), reply.end(), '\n');
+}
+
+// Called by workers.
+void finishRequest(Server &server, int fd, string &&reply, size_t line) {
+    {
+        lock_guard<mutex> guard(server.lock);
+        server.finished.push_back({fd, move(reply), line});
+    }
+    char byte = 0;
+    if (write(server.wake[1], &byte, 1) < 0) {}   // full pipe: a wake-up is already pending
+}
+
+// Runs one request on the server's own boards. Returns whether it ran on
+// a journaled board.
+bool runRequest(Server &server, Connection &conn, RequestKind kind, const string &text) {
+    string reply;
+    if (kind == REQUEST_COMMANDS) {
+        ServedBoard &board = server.boards[conn.board];
+        istringstream in(text);
+        BatchRunner runner(board.list, board.undo, in, true);
+        runner.line = conn.line;
+        runner.reply = &reply;
+        runner.runAll();
+        conn.line = runner.line;
+        queueReply(conn, reply);
+        return board.undo.journal != nullptr;
+    }
+    ++conn.line;
+    if (kind == REQUEST_BOARD) {
+        string name = requestArgument(requestLine(text, 0, text.size() - 1));
+        if (!validBoardName(name)) {
+            appendRequestError(reply, true, conn.line, "board", BOARD_NAME_ERROR);
+        } else {
+            auto it = server.boards.find(name);
+            if (it == server.boards.end()) {
+                it = server.boards.emplace(name, ServedBoard()).first;
+                it->second.list.name = name;
+                it->second.undo.budgetBytes = server.boards["main"].undo.budgetBytes;
+            }
+            conn.board = name;
+            appendBoardReply(reply, true, conn.line, name, it->second.list.tasks.size());
+        }
+    } else {
+        FilterExpr expr;
+        string error;
+        vector<WorkspaceMatch> matches;
+        if (parseFilterExpr(requestArgument(requestLine(text, 0, text.size() - 1)), expr, error)) {
+            for (const auto &board : server.boards) {
+                vector<WorkspaceMatch> found = matchTasks(board.second.list, board.first, expr, SIZE_MAX);
+                move(found.begin(), found.end(), back_inserter(matches));
+            }
+            mergeMatches(matches, SIZE_MAX);
+        }
+        appendAcrossReply(reply, true, conn.line, matches, error);
+    }
+    queueReply(conn, reply);
+    return false;
+}
+
+// Hands one request to the workspace; its reply comes back through
+// finishRequest, and the connection waits for it before running more.
+void startRequest(Server &server, Connection &conn, RequestKind kind, const string &text) {
+    Workspace &ws = *server.workspace;
+    int fd = conn.fd;
+    size_t line = conn.line;
+    conn.busy = true;
+    if (kind == REQUEST_COMMANDS) {
+        postToBoard(ws, conn.board, [&server, fd, line, text](WorkspaceBoard &board) {
+            istringstream in(text);
+            string reply;
+            BatchRunner runner = runOnBoard(board, in, true, line, &reply);
+            finishRequest(server, fd, move(reply), runner.line);
+        });
+        return;
+    }
+    string argument = requestArgument(requestLine(text, 0, text.size() - 1));
+    if (kind == REQUEST_BOARD) {
+        if (!validBoardName(argument)) {
+            string reply;
+            appendRequestError(reply, true, line + 1, "board", BOARD_NAME_ERROR);
+            return finishRequest(server, fd, move(reply), line + 1);
+        }
+        conn.board = argument;
+        postToBoard(ws, argument, [&server, fd, line](WorkspaceBoard &board) {
+            string reply;
+            appendBoardReply(reply, true, line + 1, board.name, board.list.tasks.size());
+            finishRequest(server, fd, move(reply), line + 1);
+        });
+        return;
+    }
+    queryWorkspaceAsync(ws, argument, SIZE_MAX, [&server, fd, line](vector<WorkspaceMatch> &&matches, const string &error) {
+        string reply;
+        appendAcrossReply(reply, true, line + 1, matches, error);
+        finishRequest(server, fd, move(reply), line + 1);
+    });
+}
+
+// Runs (or, with a workspace, starts) the complete requests in conn.in.
+// Returns whether any of them ran on a journaled board.
+bool serveRequests(Server &server, Connection &conn) {
+    bool journaled = false;
+    size_t pos = 0, end;
+    RequestKind kind;
+    while (!conn.busy && nextRequests(conn.in, pos, kind, end, conn.eof)) {
+        string text = conn.in.substr(pos, end - pos);
+        pos = end;
+        if (server.workspace) startRequest(server, conn, kind, text);
+        else journaled |= runRequest(server, conn, kind, text);
+    }
+    conn.in.erase(0, pos);
+    return journaled;
+}
+
+// Serves `list` as "main" (plus the --board files) until SIGINT/SIGTERM,
+// then hands it back. With a workspace, serves its boards instead.
+int runServer(ToDoList &list, UndoLog &undo, Workspace *workspace, const string &address,
+              const vector<pair<string, string>> &boardFiles) {
+    Server server;
+    server.workspace = workspace;
+    string error;
+    for (const auto &file : boardFiles) {
+        ServedBoard &board = server.boards[file.first];
+        board.list.name = file.first;
+        board.undo.budgetBytes = undo.budgetBytes;
+        if (!openBoardFile(board.list, file.second, error)) {
+            cerr << "❌ Could not open " << file.second << ": " << error << "\n";
+            return 1;
+        }
+    }
+    int listener = listenOn(address, error);
+    if (listener < 0) {
+        cerr << "❌ Could not listen on " << address << ": " << error << "\n";
+        return 1;
+    }
+    if (pipe(server.wake) != 0) {
+        cerr << "❌ pipe: " << strerror(errno) << "\n";
+        close(listener);
+        return 1;
+    }
+    fcntl(server.wake[0], F_SETFL, O_NONBLOCK);
+    fcntl(server.wake[1], F_SETFL, O_NONBLOCK);
+    Journal *journal = undo.journal;
+    if (!workspace) {
+        server.boards["main"].list = move(list);
+        server.boards["main"].undo = move(undo);
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGINT, stopServer);
+    signal(SIGTERM, stopServer);
+    if (workspace) {
+        cout << "🛰️ Serving workspace " << workspace->directory << " (" << workspaceStats(*workspace).boards
+             << " board(s), " << workspace->workers.size() << " worker(s)) on " << address << "; Ctrl+C stops.\n" << flush;
+    } else {
+        cout << "🛰️ Serving " << server.boards.size() << " board(s) on " << address << "; Ctrl+C stops.\n" << flush;
+    }
+
+    map<int, Connection> conns;
+    vector<pollfd> fds;
+    vector<char> buf(SERVER_READ_BYTES);
+    size_t connections = 0, requests = 0;
+    while (!serverStop) {
+        fds.assign({pollfd{listener, POLLIN, 0}, pollfd{server.wake[0], POLLIN, 0}});
+        for (const auto &entry : conns) {
+            const Connection &c = entry.second;
+            short events = 0;
+            size_t waiting = c.busy ? c.in.size() : 0;   // requests read but not yet started
+            if (!c.eof && c.out.size() - c.sent + waiting < SERVER_MAX_BACKLOG) events |= POLLIN;
+            if (c.sent < c.out.size()) events |= POLLOUT;
+            fds.push_back(pollfd{c.fd, events, 0});
+        }
+        if (poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) continue;
+            cerr << "❌ poll: " << strerror(errno) << "\n";
+            break;
+        }
+
+        // Replies from the workspace; each connection then carries on with what it has read
+        if (fds[1].revents & POLLIN) {
+            char drain[256];
+            while (read(server.wake[0], drain, sizeof(drain)) > 0) {}
+            vector<FinishedRequest> finished;
+            {
+                lock_guard<mutex> guard(server.lock);
+                finished.swap(server.finished);
+            }
+            for (FinishedRequest &done : finished) {
+                Connection &c = conns.at(done.fd);
+                queueReply(c, done.reply);
+                c.line = done.line;
+                c.busy = false;
+                serveRequests(server, c);
+            }
+        }
+
+        // Read and run everything that arrived
+        bool journaled = false;
+        size_t i = 2;
+        for (auto &entry : conns) {
+            Connection &c = entry.second;
+            if (!(fds[i++].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+            for (size_t got = 0; got < 16 * SERVER_READ_BYTES;) {
+                ssize_t n = read(c.fd, buf.data(), buf.size());
+                if (n > 0) {
+                    c.in.append(buf.data(), (size_t)n);
+                    got += (size_t)n;
+                    continue;
+                }
+                if (n < 0 && errno == EINTR) continue;
+                if (n == 0) c.eof = true;
+                else if (errno != EAGAIN && errno != EWOULDBLOCK) c.broken = true;
+                break;
+            }
+            if (c.eof && !c.in.empty() && c.in.back() != '\n') c.in += '\n';
+            journaled |= serveRequests(server, c);
+            if (!c.busy && c.in.size() > SERVER_MAX_REQUEST) {
+                queueReply(c, "{\"line\":" + to_string(c.line + 1) + ",\"ok\":false,\"error\":\"request too large\"}\n");
+                c.in.clear();
+                c.eof = true;
+            }
+        }
+        // One fsync covers every edit of the round, before any reply says it's done
+        if (journaled && !syncJournal(*journal))
+            cerr << "⚠️ Could not write the journal; recent edits may be lost if the server exits.\n";
+
+        // Everything owed to a connection goes out together
+        for (auto &entry : conns) {
+            Connection &c = entry.second;
+            while (c.sent < c.out.size() && !c.broken) {
+                ssize_t n = write(c.fd, c.out.data() + c.sent, c.out.size() - c.sent);
+                if (n > 0) c.sent += (size_t)n;
+                else if (n < 0 && errno == EINTR) continue;
+                else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+                else c.broken = true;
+            }
+            if (c.sent == c.out.size()) {
+                c.out.clear();
+                c.sent = 0;
+            }
+        }
+        // A connection with a request on a worker stays open until the reply is back
+        for (auto it = conns.begin(); it != conns.end();) {
+            const Connection &c = it->second;
+            if (c.busy || (!c.broken && !(c.eof && c.out.empty()))) {
+                ++it;
+                continue;
+            }
+            close(c.fd);
+            requests += c.requests;
+            it = conns.erase(it);
+        }
+
+        if (fds[0].revents & POLLIN) {
+            int fd;
+            while ((fd = accept(listener, nullptr, nullptr)) >= 0) {
+                int one = 1;
+                fcntl(fd, F_SETFL, O_NONBLOCK);
+                setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));   // fails harmlessly on Unix sockets
+                conns.emplace(fd, Connection(fd));
+                ++connections;
+            }
+        }
+    }
+
+    // Let the workers finish what they were given before the server goes away
+    if (workspace) closeWorkspace(*workspace);
+    for (const auto &entry : conns) {
+        close(entry.first);
+        requests += entry.second.requests;
+    }
+    close(listener);
+    close(server.wake[0]);
+    close(server.wake[1]);
+    if (address.find('/') != string::npos) unlink(address.c_str());
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+    cout << "\n🏁 Served " << requests << " request(s) over " << connections << " connection(s).\n";
+    if (!workspace) {
+        list = move(server.boards["main"].list);
+        undo = move(server.boards["main"].undo);
+    }
+    return 0;
+}
+
+
+// ---------- Load generator (ToDoList --load <address> [--clients N] [--requests N] [--pipeline N] [--rows N]) ----------
+// Drives a running server the way a crowd of users would. It first fills
+// the board "loadgen" with `rows` tasks (default 10000); then each of
+// `clients` threads (default 8) opens its own connection and sends
+// `requests` requests (default 20000), keeping `pipeline` of them (default
+// 16) in flight, sent with one write. The mix is 20% add, 30% update,
+// 10% delete (of a task the client added), 25% schedule,10 and 15%
+// alerts,10. Latency runs from a request's write to its reply.
+
+struct LoadOptions {
+    string address;
+    unsigned clients = 8;
+    size_t requests = 20000;
+    size_t pipeline = 16;
+    size_t rows = 10000;
+    int firstId = 1;   // of the tasks added by the fill
+};
+
+const char *const LOAD_PRIORITIES[] = {"High", "Medium", "Low"};
+
+// A task in add's format, due some time in the next 30 days.
+string loadTaskFields(BoardRng &rng, size_t n) {
+    return "load task " + to_string(n) + "," + LOAD_PRIORITIES[rng.below(3)] + "," +
+           formatDateTime(nowWallMinutes() + (long long)rng.below(30 * 1440));
+}
+
+// Value after `"key":` in a JSON reply, or -1.
+long long replyNumber(string_view reply, string_view key) {
+    size_t at = reply.find(key);
+    long long value = -1;
+    if (at != string_view::npos) from_chars(reply.data() + at + key.size(), reply.data() + reply.size(), value);
+    return value;
+}
+
+// One client: its latencies go into `latency`, replies with "ok":false
+// are counted in `rejected`.
+bool runLoadClient(const LoadOptions &opt, unsigned index, MetricStats &latency, atomic<size_t> &rejected,
+                   string &error) {
+    int fd = connectTo(opt.address, error);
+    if (fd < 0) return false;
+    BoardRng rng{0x10ADull * (index + 1)};
+    deque<pair<chrono::steady_clock::time_point, char>> inFlight;   // send time, kind
+    vector<int> added;
+    string batch = "board,loadgen\n", in;
+    inFlight.push_back({chrono::steady_clock::now(), 'b'});
+    vector<char> buf(64 << 10);
+    size_t sent = 0, done = 0;
+    while (done < opt.requests) {
+        auto now = chrono::steady_clock::now();
+        while (sent < opt.requests && inFlight.size() < opt.pipeline) {
+            uint64_t pick = rng.below(100);
+            char kind = pick < 20 ? 'a' : pick < 50 ? 'u' : pick < 60 ? 'd' : pick < 85 ? 's' : 'l';
+            if (kind == 'd' && added.empty()) kind = 'a';
+            if (kind == 'a') batch += "add," + loadTaskFields(rng, sent) + "\n";
+            if (kind == 'u')
+                batch += "update," + to_string(opt.firstId + (int)rng.below(opt.rows)) + ",Status," +
+                         (rng.below(2) ? "In progress\n" : "Pending\n");
+            if (kind == 'd') {
+                batch += "delete," + to_string(added.back()) + "\n";
+                added.pop_back();
+            }
+            if (kind == 's') batch += "schedule,10\n";
+            if (kind == 'l') batch += "alerts,10\n";
+            inFlight.push_back({now, kind});
+            ++sent;
+        }
+        if (!batch.empty() && !writeAll(fd, batch)) break;
+        batch.clear();
+        ssize_t n = read(fd, buf.data(), buf.size());
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        in.append(buf.data(), (size_t)n);
+        size_t pos = 0, eol;
+        while ((eol = in.find('\n', pos)) != string::npos && !inFlight.empty()) {
+            string_view reply(in.data() + pos, eol - pos);
+            char kind = inFlight.front().second;
+            if (kind != 'b') {
+                latency.record((uint64_t)chrono::duration_cast<chrono::nanoseconds>(
+                    chrono::steady_clock::now() - inFlight.front().first).count());
+                ++done;
+            }
+            inFlight.pop_front();
+            if (reply.find("\"ok\":true") == string_view::npos) ++rejected;
+            else if (kind == 'a') added.push_back((int)replyNumber(reply, "\"id\":"));
+            pos = eol + 1;
+        }
+        in.erase(0, pos);
+    }
+    close(fd);
+    if (done < opt.requests) error = "the server closed the connection";
+    return done == opt.requests;
+}
+
+int runLoadGenerator(int argc, char *argv[]) {
+    LoadOptions opt;
+    opt.address = argv[2];
+    for (int i = 3; i + 1 < argc; ++i) {
+        string arg = argv[i];
+        size_t value = (size_t)max(1, atoi(argv[i + 1]));
+        if (arg == "--clients") opt.clients = (unsigned)value;
+        if (arg == "--requests") opt.requests = value;
+        if (arg == "--pipeline") opt.pipeline = value;
+        if (arg == "--rows") opt.rows = value;
+    }
+
+    // Fill the board in one bulk request
+    string error;
+    int fd = connectTo(opt.address, error);
+    if (fd < 0) {
+        cerr << "❌ Could not connect to " << opt.address << ": " << error << "\n";
+        return 1;
+    }
+    BoardRng rng{42};
+    string fill = "board,loadgen\nbulk\n";
+    for (size_t i = 0; i < opt.rows; ++i) fill += loadTaskFields(rng, i) + "\n";
+    fill += "end\n";
+    string replies;
+    char buf[4096];
+    ssize_t n = 0;
+    bool ok = writeAll(fd, fill);
+    while (ok && count(replies.begin(), replies.end(), '\n') < 2 && (n = read(fd, buf, sizeof(buf))) > 0)
+        replies.append(buf, (size_t)n);
+    close(fd);
+    opt.firstId = (int)replyNumber(replies, "\"firstId\":");
+    if (opt.firstId < 0) {
+        cerr << "❌ Could not fill the board: " << (replies.empty() ? "no reply" : replies) << "\n";
+        return 1;
+    }
+    fprintf(stderr, "Filled \"loadgen\" with %zu tasks; %u client(s) x %zu request(s), %zu in flight each...\n",
+            opt.rows, opt.clients, opt.requests, opt.pipeline);
+
+    auto latency = make_unique<MetricStats>();
+    atomic<size_t> rejected(0);
+    vector<string> errors(opt.clients);
+    vector<thread> clients;
+    auto start = chrono::steady_clock::now();
+    for (unsigned c = 0; c < opt.clients; ++c)
+        clients.emplace_back([&, c] { runLoadClient(opt, c, *latency, rejected, errors[c]); });
+    for (auto &t : clients) t.join();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    for (const string &e : errors)
+        if (!e.empty()) cerr << "❌ " << e << "\n";
+    uint64_t total = latency->count.load();
+    printf("🏁 %llu request(s) in %.2f s: %.0f requests/sec, %zu rejected\n", (unsigned long long)total, seconds,
+           total / seconds, rejected.load());
+    printf("   latency p50 %s, p90 %s, p99 %s, p99.9 %s, max %s\n", formatNanos(latency->percentileNs(0.5)).c_str(),
+           formatNanos(latency->percentileNs(0.9)).c_str(), formatNanos(latency->percentileNs(0.99)).c_str(),
+           formatNanos(latency->percentileNs(0.999)).c_str(), formatNanos(latency->maxNs.load()).c_str());
+    return total == opt.clients * opt.requests ? 0 : 1;
+}
+
+#else
+
+int runServer(ToDoList &, UndoLog &, Workspace *, const string &, const vector<pair<string, string>> &) {
+    cerr << "❌ --serve isn't available on Windows yet.\n";
+    return 1;
+}
+
+int runLoadGenerator(int, char *[]) {
+    cerr << "❌ --load isn't available on Windows yet.\n";
+    return 1;
+}
+
+#endif
+
+
+int main(int argc, char *argv[]) {
+    setlocale(LC_ALL, "en_US.UTF-8");
+#ifdef _WIN32
+    SetConsoleOutputCP(CP_UTF8);
+#endif
+    if (argc >= 2 && string(argv[1]) == "--bench-scan") {
+        benchScanKernels(argc >= 3 ? argv[2] : "");
+        return 0;
+    }
+    if (argc >= 2 && string(argv[1]) == "--bench") return runBenchmarks(argc, argv);
+    if (argc >= 3 && string(argv[1]) == "--load") return runLoadGenerator(argc, argv);
+    if (argc >= 3 && string(argv[1]) == "--generate") {
+        BoardSpec spec;
+        string error;
+        if (!parseBoardSpec(argc, argv, spec, error)) {
+            cerr << "❌ " << error << "\n";
+            return 1;
+        }
+        return generateBoardFile(argv[2], spec);
+    }
+
+    ToDoList todo;
+    todo.name = "Smart Task List";
+    UndoLog undo;
+    string openPath, journalBase, batchPath, metricsPath, serveAddress, workspaceDir;
+    vector<pair<string, string>> boardFiles;   // --board name=file, served next to "main"
+    Workspace workspace;
+    unsigned workers = 0;
+    bool json = false;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--json") json = true;
+        if (i + 1 == argc) break;
+        if (arg == "--undo-mb") undo.budgetBytes = (size_t)max(1, atoi(argv[i + 1])) << 20;
+        if (arg == "--open") openPath = argv[i + 1];
+        if (arg == "--journal") journalBase = argv[i + 1];
+        if (arg == "--batch") batchPath = argv[i + 1];
+        if (arg == "--metrics") metricsPath = argv[i + 1];
+        if (arg == "--serve") serveAddress = argv[i + 1];
+        if (arg == "--workspace") workspaceDir = argv[i + 1];
+        if (arg == "--workers") workers = (unsigned)max(1, atoi(argv[i + 1]));
+        if (arg == "--workspace-mb") workspace.budgetBytes = (size_t)max(1, atoi(argv[i + 1])) << 20;
+        if (arg == "--board") {
+            string spec = argv[i + 1];
+            size_t eq = spec.find('=');
+            if (eq == string::npos || !validBoardName(spec.substr(0, eq)) || spec.substr(0, eq) == "main") {
+                cerr << "❌ expected --board <name>=<file> (the name made of letters, digits, '-', '_' and '.', not main)\n";
+                return 1;
+            }
+            boardFiles.emplace_back(spec.substr(0, eq), spec.substr(eq + 1));
+        }
+    }
+    // Warnings go to stderr when stdout carries JSON
+    auto warn = [json = json && !batchPath.empty()](const string &message) {
+        (json ? cerr : cout) << "⚠️ " << message << "\n";
+    };
+    undo.warn = warn;
+    // Many boards, read when first used and kept on disk as snapshots
+    if (!workspaceDir.empty()) {
+        string error;
+        if (!journalBase.empty() || !openPath.empty() || !boardFiles.empty() || (serveAddress.empty() && batchPath.empty())) {
+            cerr << "❌ --workspace works with --serve or --batch, and keeps its boards in its directory"
+                    " (no --journal, --open or --board)\n";
+            return 1;
+        }
+        workspace.undoBudgetBytes = min(workspace.undoBudgetBytes, undo.budgetBytes);
+        workspace.warn = [warn](const string &message) {
+            static mutex printing;
+            lock_guard<mutex> guard(printing);
+            warn(message);
+        };
+        if (!openWorkspace(workspace, workspaceDir, workers, error)) {
+            cerr << "❌ " << error << "\n";
+            return 1;
+        }
+    }
+    // Pick up where the journal left off; from here on every edit is written to it
+    Journal journal;
+    journal.warn = warn;
+    if (!journalBase.empty()) {
+        string error;
+        if (!openJournal(journal, todo, journalBase, error)) {
+            cout << "❌ " << error << "\n";
+            return 1;
+        }
+        cout << "📒 Journal " << journalBase << ": " << todo.tasks.size() << " task(s), replayed "
+             << journal.replayed << " edit(s) since the last snapshot.\n";
+        undo.journal = &journal;
+    }
+    // Start on a saved board: a .tbs snapshot opens without parsing
+    if (!openPath.empty()) {
+        ToDoList opened;
+        opened.name = todo.name;
+        string error;
+        if (openBoardFile(opened, openPath, error)) replaceList(todo, move(opened), undo);
+        else cout << "❌ Could not open " << openPath << ": " << error << "\n";
+    }
+    // Serve the board until stopped; each round of edits is synced before it's acknowledged
+    if (!serveAddress.empty()) {
+        int code = runServer(todo, undo, workspaceDir.empty() ? nullptr : &workspace, serveAddress, boardFiles);
+        closeJournal(journal);
+        if (!workspaceDir.empty()) printWorkspaceStats(workspace, cout);
+        if (!metricsPath.empty() && !writeMetrics(metricsPath)) cerr << "❌ Could not write " << metricsPath << "\n";
+        return code;
+    }
+    // Headless: run the script and exit non-zero if any command failed
+    if (!batchPath.empty()) {
+        ifstream script;
+        if (batchPath != "-") {
+            script.open(batchPath);
+            if (!script) {
+                cerr << "❌ Could not open " << batchPath << "\n";
+                return 1;
+            }
+        }
+        istream &in = batchPath == "-" ? cin : script;
+        size_t failed = workspaceDir.empty() ? runBatch(todo, undo, in, json) : runWorkspaceBatch(workspace, in, json);
+        bool synced = undo.journal == nullptr || syncJournal(journal);
+        if (!synced) cerr << "⚠️ Could not write the journal.\n";
+        closeJournal(journal);
+        if (!workspaceDir.empty()) printWorkspaceStats(workspace, json ? cerr : cout);
+        if (!metricsPath.empty() && !writeMetrics(metricsPath)) cerr << "❌ Could not write " << metricsPath << "\n";
+        return failed == 0 && synced ? 0 : 2;
+    }
+    AlertEngine alerts;
+    int choice;
+
+    while (true) {
+        displayMenu();
+        cout << "Enter your choice: ";
+        cin >> choice;
+        cin.ignore();
         cout << "\n";
         if (choice == 0) break;
-        // Save a snapshot before any action that modifies the list, so
-        // it can be restored with "Undo". Read-only actions (3, 11, 15)
-        // and Undo itself (16) don't push a snapshot.
-        if (choice != 3 && choice != 11 && choice != 15 && choice != 16)
-            undoStack.push(todo);
+        if (choice == 18) {
+            if (alerts.worker.joinable()) {
+                stopAlerts(alerts);
+                cout << "🔕 Background alerts off.\n";
+            } else {
+                startAlerts(alerts, todo);
+                cout << "🔔 Background alerts on.\n";
+            }
+            continue;
+        }
 
+        // Editing actions record their own undo steps; read-only ones
+        // (print, save, filter, stats, schedule, alerts, search) record nothing.
+        unique_lock<mutex> busy(alerts.lock);
         switch (choice) {
-            case 1: addColumn(todo); break;
-            case 2: addTask(todo); break;
+            case 1: addColumn(todo, undo); break;
+            case 2: addTask(todo, undo); break;
             case 3: printToDoList(todo); break;
-            case 4: updateCell(todo); break;
-            case 5: deleteTask(todo); break;
-            case 6: deleteColumn(todo); break;
+            case 4: updateCell(todo, undo); break;
+            case 5: deleteTask(todo, undo); break;
+            case 6: deleteColumn(todo, undo); break;
             case 7: saveToCSV(todo); break;
-            case 8: loadFromCSV(todo); break;
-            case 9: sortByColumn(todo); break;
+            case 8: loadFromCSV(todo, undo); break;
+            case 9: sortByColumn(todo, undo); break;
             case 10: filterTasks(todo); break;
             case 11: getStats(todo); break;
             case 12: scheduleTasks(todo); break;
             case 13: showCategorizedAlerts(todo); break;
-            case 14: removeCompletedTasks(todo); break;
+            case 14: removeCompletedTasks(todo, undo); break;
             case 15: viewFullCell(todo); break;
             case 16:
-                if (undoStack.empty()) {
-                    cout << "Nothing to undo.\n";
-                } else {
-                    todo = undoStack.top();
-                    undoStack.pop();
-                    cout << "↩️ Last action undone.\n";
-                }
+                if (undoLast(todo, undo)) cout << "↩️ Last action undone.\n";
+                else cout << "Nothing to undo.\n";
                 break;
+            case 17: fastLoadFromCSV(todo, undo); break;
+            case 19: saveSnapshot(todo); break;
+            case 20: openSnapshot(todo, undo); break;
+            case 21: searchBoard(todo); break;
             default: cout << "Invalid choice.\n";
         }
+        busy.unlock();
+        alerts.wake.notify_one();
+        if (undo.journal != nullptr && !syncJournal(journal))
+            cout << "⚠️ Could not write the journal; recent edits may be lost if the program exits.\n";
     }
 
+    stopAlerts(alerts);
+    closeJournal(journal);
+    if (!metricsPath.empty() && !writeMetrics(metricsPath)) cout << "❌ Could not write " << metricsPath << "\n";
     return 0;
 }